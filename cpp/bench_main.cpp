@@ -0,0 +1,489 @@
+#include "shared/utils.h"
+#include "shared/arena.h"
+#include "shared/most_common.h"
+#include "shared/lrs_test.h"
+#include "shared/shuffle.h"
+#include "non_iid/collision_test.h"
+#include "non_iid/lz78y_test.h"
+#include "non_iid/multi_mmc_test.h"
+#include "non_iid/lag_test.h"
+#include "non_iid/multi_mcw_test.h"
+#include "non_iid/compression_test.h"
+#include "non_iid/markov_test.h"
+#include "non_iid/non_iid_assess.h"
+#include "iid/permutation_tests.h"
+#include "iid/chi_square_tests.h"
+#include <getopt.h>
+#include <errno.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+//The default number of synthetic samples, and the default alphabets when no files are given
+#define BENCH_SAMPLES 1000000L
+#define BENCH_ALPHABETS "2,16,256"
+#define BENCH_REPEATS 3
+
+enum bench_view {
+	BENCH_LITERAL,
+	BENCH_BITSTRING
+};
+
+//The data that an estimator is timed on. The permutation statistics also need the raw samples and their
+//mean and median, as they get from the permutation loop.
+struct bench_input {
+	const data_t *dp;
+	byte *data;
+	long len;
+	int alph_size;
+	double rawmean;
+	double median;
+};
+
+//The results are stored here so that the compiler can't discard the work that produces them
+static volatile double bench_sink;
+static long double bench_stats[num_tests];
+
+typedef void (*bench_fn)(const struct bench_input *in, struct arena *scratch);
+
+struct bench_case {
+	const char *name;
+	enum bench_view view;	// the binary-only estimators are timed on the bitstring
+	bench_fn run;
+};
+
+static void bench_most_common(const struct bench_input *in, struct arena *scratch) {
+	bench_sink = most_common(in->data, in->len, in->alph_size, 0, "");
+}
+
+static void bench_collision(const struct bench_input *in, struct arena *scratch) {
+	bench_sink = collision_test(in->data, in->len, 0, "");
+}
+
+static void bench_markov(const struct bench_input *in, struct arena *scratch) {
+	bench_sink = markov_test(in->data, in->len, 0, "");
+}
+
+static void bench_compression(const struct bench_input *in, struct arena *scratch) {
+	bench_sink = compression_test(in->data, in->len, 0, "");
+}
+
+static void bench_saalgs(const struct bench_input *in, struct arena *scratch) {
+	double t_tuple, lrs;
+
+	SAalgs(in->data, in->len, in->alph_size, t_tuple, lrs, 0, "", scratch);
+	bench_sink = t_tuple + lrs;
+}
+
+static void bench_multi_mcw(const struct bench_input *in, struct arena *scratch) {
+	bench_sink = multi_mcw_test(in->data, in->len, in->alph_size, 0, "");
+}
+
+static void bench_lag(const struct bench_input *in, struct arena *scratch) {
+	bench_sink = lag_test(in->data, in->len, in->alph_size, 0, "");
+}
+
+static void bench_multi_mmc(const struct bench_input *in, struct arena *scratch) {
+	bench_sink = multi_mmc_test(in->data, in->len, in->alph_size, 0, "", scratch);
+}
+
+static void bench_lz78y(const struct bench_input *in, struct arena *scratch) {
+	bench_sink = LZ78Y_test(in->data, in->len, in->alph_size, 0, "", scratch);
+}
+
+static void bench_chi_square(const struct bench_input *in, struct arena *scratch) {
+	bench_sink = chi_square_tests(in->data, in->len, in->alph_size, 0);
+}
+
+static void bench_len_lrs(const struct bench_input *in, struct arena *scratch) {
+	bench_sink = len_LRS_test(in->data, in->len, in->alph_size, 0, "", scratch);
+}
+
+//The permutation statistics are timed as one permutation computes them, on the unshuffled data
+static const bool all_tests[num_tests] = {true, true, true, true, true, true, true, true, true, true, true, true, true, true, true, true, true, true, true};
+
+static void bench_shuffle(const struct bench_input *in, struct arena *scratch) {
+	struct random_stream rs;
+
+	random_stream_init_keyed(&rs, 0, 0);
+	if(in->len >= SHUFFLE_BUCKETED_MIN) bucket_shuffle(in->data, in->len, &rs, scratch);
+	else FYshuffle(in->data, in->len, &rs);
+}
+
+static void bench_excursion(const struct bench_input *in, struct arena *scratch) {
+	excursion_test(in->dp->rawsymbols, in->rawmean, in->len, bench_stats, all_tests);
+}
+
+static void bench_directional(const struct bench_input *in, struct arena *scratch) {
+	directional_tests(in->data, in->alph_size, in->len, bench_stats, all_tests, scratch);
+}
+
+static void bench_median_runs(const struct bench_input *in, struct arena *scratch) {
+	consecutive_runs_tests(in->data, in->median, in->alph_size, in->len, bench_stats, all_tests);
+}
+
+static void bench_collisions(const struct bench_input *in, struct arena *scratch) {
+	collision_tests(in->data, in->alph_size, in->len, bench_stats, all_tests, scratch);
+}
+
+static void bench_lags(const struct bench_input *in, struct arena *scratch) {
+	lag_tests((in->alph_size == 2) ? in->data : in->dp->rawsymbols, in->alph_size, in->len, bench_stats, all_tests, scratch);
+}
+
+static void bench_bzip2(const struct bench_input *in, struct arena *scratch) {
+	compression_test(in->dp->rawsymbols, in->len, bench_stats, in->dp->maxsymbol, all_tests, scratch);
+}
+
+static const struct bench_case bench_cases[] = {
+	{"most_common", BENCH_LITERAL, bench_most_common},
+	{"collision_test", BENCH_BITSTRING, bench_collision},
+	{"markov_test", BENCH_BITSTRING, bench_markov},
+	{"compression_test", BENCH_BITSTRING, bench_compression},
+	{"SAalgs", BENCH_LITERAL, bench_saalgs},
+	{"multi_mcw_test", BENCH_LITERAL, bench_multi_mcw},
+	{"lag_test", BENCH_LITERAL, bench_lag},
+	{"multi_mmc_test", BENCH_LITERAL, bench_multi_mmc},
+	{"LZ78Y_test", BENCH_LITERAL, bench_lz78y},
+	{"chi_square_tests", BENCH_LITERAL, bench_chi_square},
+	{"len_LRS_test", BENCH_LITERAL, bench_len_lrs},
+	{"perm_shuffle", BENCH_LITERAL, bench_shuffle},
+	{"perm_excursion", BENCH_LITERAL, bench_excursion},
+	{"perm_directional_runs", BENCH_LITERAL, bench_directional},
+	{"perm_median_runs", BENCH_LITERAL, bench_median_runs},
+	{"perm_collisions", BENCH_LITERAL, bench_collisions},
+	{"perm_lags", BENCH_LITERAL, bench_lags},
+	{"perm_compression", BENCH_LITERAL, bench_bzip2}
+};
+
+#define BENCH_CASES (sizeof(bench_cases) / sizeof(bench_cases[0]))
+
+//The timings of one case, as sent back from the child process that ran it
+struct bench_timing {
+	bool ok;
+	double best_ns;
+	double median_ns;
+	double cpu_ns;		// the CPU time of all the repeats, in all threads
+};
+
+struct bench_settings {
+	int repeats;
+	bool csv;
+	vector<bool> enabled;	// by bench_cases index
+};
+
+[[ noreturn ]] void print_usage(){
+	printf("Usage is: ea_bench [-n <samples>] [-k <alphabets>] [-r <repeats>] [-e <estimators>] [-o json|csv] [--seed <seed>] [<file_name>[:bits_per_symbol] ...]\n\n");
+	printf("\t Times each estimator on each file, and on synthetic data drawn uniformly from each of the given alphabets,\n");
+	printf("\t and prints one record per input and estimator: the time per symbol and the throughput of the fastest\n");
+	printf("\t repeat, the median, the CPU time, and the peak resident memory of the process that ran it.\n");
+	printf("\t Each estimator is run in a separate process, so that its peak memory can be measured.\n\n");
+	printf("\t <file_name>: A file of samples, one per byte. The bits per symbol are inferred from the data unless given.\n");
+	printf("\t -n <samples>: The length of the synthetic inputs (default %ld).\n", BENCH_SAMPLES);
+	printf("\t -k <alphabets>: A comma separated list of synthetic alphabet sizes, from 2 to 256 (default %s\n", BENCH_ALPHABETS);
+	printf("\t if no files are given; otherwise none).\n");
+	printf("\t -r <repeats>: The number of times that each estimator is run on each input (default %d).\n", BENCH_REPEATS);
+	printf("\t -e <estimators>: A comma separated list of the estimators to time (default all). The estimators are:\n\t ");
+	for(unsigned int i = 0; i < BENCH_CASES; i++) printf("%s%s", bench_cases[i].name, (i + 1 < BENCH_CASES) ? ", " : "\n");
+	printf("\t -o json|csv: JSON (one object per line, the default) or CSV with a header line.\n");
+	printf("\t --seed <seed>: The seed for the synthetic data (default 0).\n");
+	printf("\n");
+	exit(-1);
+}
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end) {
+	return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+//The resident memory of this process now, in kB
+static long current_rss_kb() {
+	long pages = 0, resident = 0;
+	FILE *statm = fopen("/proc/self/statm", "r");
+
+	if(statm == NULL) return 0;
+	if(fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+	fclose(statm);
+
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+//Runs one case repeats times in the child process, and writes its timing to fd. The estimators' own output
+//is discarded, so that it doesn't mix with the records.
+[[ noreturn ]] static void bench_child(const struct bench_case *c, const struct bench_input *in, int repeats, int fd) {
+	struct bench_timing timing;
+	struct arena scratch;
+	struct timespec start, end, cpu_start, cpu_end;
+	vector<double> times;
+	vector<byte> copy;
+	int null_fd = open("/dev/null", O_WRONLY);
+
+	if(null_fd >= 0) dup2(null_fd, STDOUT_FILENO);
+
+	//The shuffle works in place, so each repeat starts from a fresh copy
+	struct bench_input run = *in;
+
+	if(c->run == bench_shuffle) {
+		copy.assign(in->data, in->data + in->len);
+		run.data = copy.data();
+	}
+
+	arena_init(&scratch, max(non_iid_scratch_size(in->dp), permutation_scratch_size(in->dp)));
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_start);
+	for(int r = 0; r < repeats; r++) {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		c->run(&run, &scratch);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		times.push_back(elapsed_ns(&start, &end));
+		arena_reset(&scratch);
+	}
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_end);
+	for(unsigned int i = 0; i < num_tests; i++) bench_sink = bench_sink + bench_stats[i];
+
+	sort(times.begin(), times.end());
+	timing.ok = true;
+	timing.best_ns = times[0];
+	timing.median_ns = times[times.size() / 2];
+	timing.cpu_ns = elapsed_ns(&cpu_start, &cpu_end);
+
+	if(write(fd, &timing, sizeof(timing)) != sizeof(timing)) _exit(1);
+	_exit(0);
+}
+
+//Writes s as a JSON string
+static void print_json_string(const char *s) {
+	putchar('"');
+	for(; *s != '\0'; s++) {
+		if((*s == '"') || (*s == '\\')) printf("\\%c", *s);
+		else if((unsigned char)*s < 0x20) printf("\\u%04x", *s);
+		else putchar(*s);
+	}
+	putchar('"');
+}
+
+static void bench_data(const char *input_name, data_t *data, const struct bench_settings *settings) {
+	double rawmean, median;
+
+	calc_stats(data, rawmean, median);
+
+	for(unsigned int i = 0; i < BENCH_CASES; i++) {
+		const struct bench_case *c = &bench_cases[i];
+		struct bench_input in;
+		struct bench_timing timing;
+		struct rusage usage;
+		int fds[2], status = 0;
+		long base_rss;
+		pid_t child;
+
+		if(!settings->enabled[i]) continue;
+
+		in.dp = data;
+		in.rawmean = rawmean;
+		in.median = median;
+		if(c->view == BENCH_BITSTRING) {
+			in.data = data->bsymbols;
+			in.len = data->blen;
+			in.alph_size = 2;
+		} else {
+			in.data = data->symbols;
+			in.len = data->len;
+			in.alph_size = data->alph_size;
+		}
+
+		if(pipe(fds) != 0) {
+			perror("pipe");
+			exit(-1);
+		}
+
+		fflush(stdout);
+		base_rss = current_rss_kb();
+		child = fork();
+		if(child < 0) {
+			perror("fork");
+			exit(-1);
+		} else if(child == 0) {
+			close(fds[0]);
+			bench_child(c, &in, settings->repeats, fds[1]);
+		}
+
+		close(fds[1]);
+		if(read(fds[0], &timing, sizeof(timing)) != sizeof(timing)) timing.ok = false;
+		close(fds[0]);
+		if(wait4(child, &status, 0, &usage) < 0) {
+			perror("wait4");
+			exit(-1);
+		}
+		if(!WIFEXITED(status) || (WEXITSTATUS(status) != 0)) timing.ok = false;
+
+		if(settings->csv) {
+			printf("%s,%s,%s,%ld,%d,%d,", input_name, c->name, (c->view == BENCH_BITSTRING) ? "bitstring" : "literal", in.len, in.alph_size, data->word_size);
+			if(timing.ok) {
+				printf("%.3f,%.3f,%.0f,%.3f,%ld,%ld\n", timing.best_ns / in.len, timing.median_ns / in.len, 1e9 * in.len / timing.best_ns,
+					timing.cpu_ns / settings->repeats / in.len, usage.ru_maxrss, max(0L, usage.ru_maxrss - base_rss));
+			} else {
+				printf(",,,,%ld,%ld\n", usage.ru_maxrss, max(0L, usage.ru_maxrss - base_rss));
+			}
+		} else {
+			printf("{\"input\": ");
+			print_json_string(input_name);
+			printf(", \"estimator\": \"%s\", \"view\": \"%s\", \"symbols\": %ld, \"alphabet\": %d, \"word_size\": %d, \"repeats\": %d, ",
+				c->name, (c->view == BENCH_BITSTRING) ? "bitstring" : "literal", in.len, in.alph_size, data->word_size, settings->repeats);
+			if(timing.ok) {
+				printf("\"ns_per_symbol\": %.3f, \"median_ns_per_symbol\": %.3f, \"symbols_per_second\": %.0f, \"cpu_ns_per_symbol\": %.3f, ",
+					timing.best_ns / in.len, timing.median_ns / in.len, 1e9 * in.len / timing.best_ns, timing.cpu_ns / settings->repeats / in.len);
+			} else {
+				printf("\"error\": \"the estimator failed\", ");
+			}
+			printf("\"peak_rss_kb\": %ld, \"added_rss_kb\": %ld}\n", usage.ru_maxrss, max(0L, usage.ru_maxrss - base_rss));
+		}
+		fflush(stdout);
+	}
+}
+
+//Parses a comma separated list of alphabet sizes
+static bool parse_alphabets(const char *list, vector<int> &alphabets) {
+	const char *p = list;
+
+	alphabets.clear();
+	while(*p != '\0') {
+		char *end;
+		long k = strtol(p, &end, 10);
+
+		if((end == p) || (k < 2) || (k > 256)) return false;
+		alphabets.push_back((int)k);
+		p = end;
+		if(*p == ',') p++;
+		else if(*p != '\0') return false;
+	}
+
+	return !alphabets.empty();
+}
+
+static bool parse_estimators(const char *list, vector<bool> &enabled) {
+	string names(list);
+	size_t start = 0;
+
+	enabled.assign(BENCH_CASES, false);
+	while(start <= names.size()) {
+		size_t end = names.find(',', start);
+		string name = names.substr(start, (end == string::npos) ? string::npos : end - start);
+		bool found = false;
+
+		for(unsigned int i = 0; i < BENCH_CASES; i++) {
+			if(name == bench_cases[i].name) {
+				enabled[i] = true;
+				found = true;
+			}
+		}
+		if(!found) {
+			printf("Unknown estimator: '%s'\n", name.c_str());
+			return false;
+		}
+
+		if(end == string::npos) break;
+		start = end + 1;
+	}
+
+	return true;
+}
+
+int main(int argc, char* argv[]){
+	struct bench_settings settings;
+	long samples = BENCH_SAMPLES;
+	uint64_t seed = 0;
+	vector<int> alphabets;
+	bool alphabets_given = false;
+	char *end;
+	int opt;
+
+	static const struct option long_options[] = {
+		{"seed", required_argument, NULL, 256},
+		{NULL, 0, NULL, 0}
+	};
+
+	settings.repeats = BENCH_REPEATS;
+	settings.csv = false;
+	settings.enabled.assign(BENCH_CASES, true);
+
+	while((opt = getopt_long(argc, argv, "n:k:r:e:o:", long_options, NULL)) != -1) {
+		switch(opt) {
+			case 'n':
+				samples = strtol(optarg, &end, 0);
+				if((*end != '\0') || (samples < 1000)) print_usage();
+				break;
+			case 'k':
+				if(!parse_alphabets(optarg, alphabets)) print_usage();
+				alphabets_given = true;
+				break;
+			case 'r':
+				settings.repeats = atoi(optarg);
+				if(settings.repeats <= 0) print_usage();
+				break;
+			case 'e':
+				if(!parse_estimators(optarg, settings.enabled)) print_usage();
+				break;
+			case 'o':
+				if(strcmp(optarg, "csv") == 0) settings.csv = true;
+				else if(strcmp(optarg, "json") == 0) settings.csv = false;
+				else print_usage();
+				break;
+			case 256:
+				errno = 0;
+				seed = strtoull(optarg, &end, 0);
+				if((errno != 0) || (end == optarg) || (*end != '\0')) print_usage();
+				break;
+			default:
+				print_usage();
+		}
+	}
+
+	argc -= optind;
+	argv += optind;
+
+	if(!alphabets_given && (argc == 0)) parse_alphabets(BENCH_ALPHABETS, alphabets);
+
+	if(settings.csv) printf("input,estimator,view,symbols,alphabet,word_size,ns_per_symbol,median_ns_per_symbol,symbols_per_second,cpu_ns_per_symbol,peak_rss_kb,added_rss_kb\n");
+
+	for(int i = 0; i < argc; i++) {
+		string path(argv[i]);
+		size_t colon = path.rfind(':');
+		data_t data;
+
+		data.word_size = 0;
+		if((colon != string::npos) && (colon + 1 < path.size()) && (strspn(path.c_str() + colon + 1, "0123456789") == path.size() - colon - 1)) {
+			data.word_size = atoi(path.c_str() + colon + 1);
+			path.resize(colon);
+			if((data.word_size < 1) || (data.word_size > 8)) print_usage();
+		}
+
+		if(!read_file(path.c_str(), &data)) {
+			printf("Error reading file '%s'.\n", path.c_str());
+			exit(-1);
+		}
+		if(data.alph_size <= 1) {
+			fprintf(stderr, "Skipping '%s': the symbol alphabet consists of 1 symbol.\n", path.c_str());
+			free_data(&data);
+			continue;
+		}
+
+		bench_data(argv[i], &data, &settings);
+		free_data(&data);
+	}
+
+	for(unsigned int a = 0; a < alphabets.size(); a++) {
+		struct random_stream rs;
+		vector<byte> buffer(samples);
+		char name[64];
+		data_t data;
+
+		random_stream_init_keyed(&rs, seed, alphabets[a]);
+		for(long i = 0; i < samples; i++) buffer[i] = (byte)randomRange64(alphabets[a] - 1, &rs);
+
+		data.word_size = 0;
+		if(!read_buffer(buffer.data(), samples, &data)) exit(-1);
+
+		snprintf(name, sizeof(name), "uniform(%d)x%ld", alphabets[a], samples);
+		bench_data(name, &data, &settings);
+		free_data(&data);
+	}
+
+	return 0;
+}
@@ -0,0 +1,739 @@
+#include "chi_square_tests.h"
+#include "../shared/profile.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+   * Cephes Math Library Release 2.8:  June, 2000
+   * Copyright 1984, 1995, 2000 by Stephen L. Moshier
+   *
+   * This software is derived from the Cephes Math Library and is
+   * incorporated herein by permission of the author.
+   *
+   * Copyright (c) 1984, 1987, 1989, 2000 by Stephen L. Moshier
+   * All rights reserved.
+   * 
+   * Redistribution and use in source and binary forms, with or without
+   * modification, are permitted provided that the following conditions are met:
+   *     * Redistributions of source code must retain the above copyright
+   *       notice, this list of conditions and the following disclaimer.
+   *     * Redistributions in binary form must reproduce the above copyright
+   *       notice, this list of conditions and the following disclaimer in the
+   *       documentation and/or other materials provided with the distribution.
+   *     * Neither the name of the organization nor the
+   *       names of its contributors may be used to endorse or promote products
+   *       derived from this software without specific prior written permission.
+   * 
+   * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+   * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+   */
+
+/*The author allowed for its use under the BSD license*/
+//https://raw.githubusercontent.com/deepmind/torch-cephes/master/LICENSE.txt
+//https://lists.debian.org/debian-legal/2004/12/msg00295.html
+
+static double MACHEP = 1.11022302462515654042E-16;     // 2**-53
+static double MAXLOG = 7.09782712893383996732224E2; // log(MAXNUM)
+static double MAXNUM = 1.7976931348623158E308;         // 2**1024*(1-MACHEP)
+static double PI     = 3.14159265358979323846;         // pi, duh!
+
+static double big = 4.503599627370496e15;
+static double biginv =  2.22044604925031308085e-16;
+
+static int sgngam = 0;
+
+/* A[]: Stirling's formula expansion of log gamma
+ * B[], C[]: log gamma function between 2 and 3
+ */
+
+static double A[] = {
+   8.11614167470508450300E-4,
+   -5.95061904284301438324E-4,
+   7.93650340457716943945E-4,
+   -2.77777777730099687205E-3,
+   8.33333333333331927722E-2
+};
+static double B[] = {
+   -1.37825152569120859100E3,
+   -3.88016315134637840924E4,
+   -3.31612992738871184744E5,
+   -1.16237097492762307383E6,
+   -1.72173700820839662146E6,
+   -8.53555664245765465627E5
+};
+static double C[] = {
+   /* 1.00000000000000000000E0, */
+   -3.51815701436523470549E2,
+   -1.70642106651881159223E4,
+   -2.20528590553854454839E5,
+   -1.13933444367982507207E6,
+   -2.53252307177582951285E6,
+   -2.01889141433532773231E6
+};
+
+#define MAXLGM 2.556348e305
+
+static double cephes_polevl(double x, double *coef, int N)
+{
+   double   ans;
+   int      i;
+   double   *p;
+
+   p = coef;
+   ans = *p++;
+   i = N;
+
+   do {
+      ans = ans * x  +  *p++;
+   } while ( --i );
+
+   return ans;
+}
+
+static double cephes_p1evl(double x, double *coef, int N)
+{
+   double   ans;
+   double   *p;
+   int      i;
+
+   p = coef;
+   ans = x + *p++;
+   i = N-1;
+
+   do {
+      ans = ans * x  + *p++;
+   } while ( --i );
+
+   return ans;
+}
+
+/* Logarithm of gamma function */
+static double cephes_lgam(double x)
+{
+   double   p, q, u, w, z;
+   int      i;
+
+   sgngam = 1;
+
+   if ( x < -34.0 ) {
+      q = -x;
+      w = cephes_lgam(q); /* note this modifies sgngam! */
+      p = floor(q);
+
+      if ( relEpsilonEqual(p, q, DBL_EPSILON, DBL_EPSILON, 4) ) {
+         goto loverf;
+      }
+
+      i = (int)p; //Note, p is the output of floor.
+
+      if ( (i & 1) == 0 ) {
+         sgngam = -1;
+      } else {
+         sgngam = 1;
+      }
+
+      z = q - p;
+
+      if ( z > 0.5 ) {
+         p += 1.0;
+         z = p - q;
+      }
+
+      z = q * sin( PI * z );
+
+      if (  relEpsilonEqual(z, 0.0, DBL_EPSILON, DBL_EPSILON, 4) ) {
+         goto loverf;
+      }
+
+      /*      z = log(PI) - log( z ) - w;*/
+      z = log(PI) - log( z ) - w;
+      return z;
+   }
+
+   if ( x < 13.0 ) {
+      z = 1.0;
+      p = 0.0;
+      u = x;
+
+      while ( u >= 3.0 ) {
+         p -= 1.0;
+         u = x + p;
+         z *= u;
+      }
+
+      while ( u < 2.0 ) {
+         if ( relEpsilonEqual(u, 0.0, DBL_EPSILON, DBL_EPSILON, 4) ) {
+            goto loverf;
+         }
+
+         z /= u;
+         p += 1.0;
+         u = x + p;
+      }
+
+      if ( z < 0.0 ) {
+         sgngam = -1;
+         z = -z;
+      } else {
+         sgngam = 1;
+      }
+
+      if ( relEpsilonEqual(u, 2.0, DBL_EPSILON, DBL_EPSILON, 4) ) {
+         return( log(z) );
+      }
+
+      p -= 2.0;
+      x = x + p;
+      p = x * cephes_polevl( x, B, 5 ) / cephes_p1evl( x, (double *)C, 6);
+
+      return log(z) + p;
+   }
+
+   if ( x > MAXLGM ) {
+loverf:
+      fprintf(stderr, "lgam: OVERFLOW\n");
+
+      return sgngam * MAXNUM;
+   }
+
+   q = ( x - 0.5 ) * log(x) - x + log( sqrt( 2*PI ) );
+
+   if ( x > 1.0e8 ) {
+      return q;
+   }
+
+   p = 1.0/(x*x);
+
+   if ( x >= 1000.0 )
+      q += ((   7.9365079365079365079365e-4 * p
+                - 2.7777777777777777777778e-3) *p
+            + 0.0833333333333333333333) / x;
+   else {
+      q += cephes_polevl( p, A, 4 ) / x;
+   }
+
+   return q;
+}
+
+static double cephes_igam(double a, double x)
+{
+   double ans, ax, c, r;
+
+   if ( (x <= 0) || ( a <= 0) ) {
+      return 0.0;
+   }
+
+   if ( (x > 1.0) && (x > a ) ) {
+      return 1.e0 - cephes_igamc(a,x);
+   }
+
+   /* Compute  x**a * exp(-x) / gamma(a)  */
+   ax = a * log(x) - x - cephes_lgam(a);
+
+   if ( ax < -MAXLOG ) {
+      fprintf(stderr, "igam: UNDERFLOW\n");
+      return 0.0;
+   }
+
+   ax = exp(ax);
+
+   /* power series */
+   r = a;
+   c = 1.0;
+   ans = 1.0;
+
+   do {
+      r += 1.0;
+      c *= x/r;
+      ans += c;
+   } while ( c/ans > MACHEP );
+
+   return ans * ax/a;
+}
+
+double cephes_igamc(double a, double x)
+{
+   double ans, ax, c, yc, r, t, y, z;
+   double pk, pkm1, pkm2, qk, qkm1, qkm2;
+
+   if ( (x <= 0) || ( a <= 0) ) {
+      return( 1.0 );
+   }
+
+   if ( (x < 1.0) || (x < a) ) {
+      return( 1.e0 - cephes_igam(a,x) );
+   }
+
+   ax = a * log(x) - x - cephes_lgam(a);
+
+   if ( ax < -MAXLOG ) {
+      fprintf(stderr, "igamc: UNDERFLOW\n");
+      return 0.0;
+   }
+
+   ax = exp(ax);
+
+   /* continued fraction */
+   y = 1.0 - a;
+   z = x + y + 1.0;
+   c = 0.0;
+   pkm2 = 1.0;
+   qkm2 = x;
+   pkm1 = x + 1.0;
+   qkm1 = z * x;
+   ans = pkm1/qkm1;
+
+   do {
+      c += 1.0;
+      y += 1.0;
+      z += 2.0;
+      yc = y * c;
+      pk = pkm1 * z  -  pkm2 * yc;
+      qk = qkm1 * z  -  qkm2 * yc;
+
+      if ( ! relEpsilonEqual(qk, 0.0, DBL_EPSILON, DBL_EPSILON, 4) ) {
+         r = pk/qk;
+         t = fabs( (ans - r)/r );
+         ans = r;
+      } else {
+         t = 1.0;
+      }
+
+      pkm2 = pkm1;
+      pkm1 = pk;
+      qkm2 = qkm1;
+      qkm1 = qk;
+
+      if ( fabs(pk) > big ) {
+         pkm2 *= biginv;
+         pkm1 *= biginv;
+         qkm2 *= biginv;
+         qkm1 *= biginv;
+      }
+   } while ( t > MACHEP );
+
+   return ans*ax;
+}
+
+double chi_square_pvalue(double x, double k){
+	return cephes_igamc(k/2.0, x/2.0);
+}
+
+void allocate_bins(const vector<double> &e, struct chi_square_binning *b){
+	vector<uint16_t> small;
+	long first_large = -1;
+	int current_bin = 0;
+	double current_expectation = 0.0;
+
+	assert(e.size() <= UINT16_MAX + 1);
+
+	for(unsigned long i = 0; i < e.size(); i++){
+		if(e[i] < 5.0) small.push_back((uint16_t)i);
+		else if((first_large < 0) || (e[i] < e[first_large])) first_large = i;
+	}
+
+	//Sort by expectation, from smallest to largest. Secondary sort on tuple value, from smallest to largest
+	sort(small.begin(), small.end(), [&e](uint16_t x, uint16_t y) { return (e[x] != e[y]) ? (e[x] < e[y]) : (x < y); });
+
+	b->bin.assign(e.size(), -1);
+	b->bin_expectations.clear();
+
+	for(unsigned long i = 0; i < small.size(); i++) bin_tuple(b, e[small[i]], small[i], current_bin, current_expectation);
+
+	if(first_large >= 0) {
+		bin_tuple(b, e[first_large], (uint16_t)first_large, current_bin, current_expectation);
+		for(unsigned long i = 0; i < e.size(); i++){
+			if((e[i] >= 5.0) && ((long)i != first_large)) bin_tuple(b, e[i], (uint16_t)i, current_bin, current_expectation);
+		}
+	}
+
+	//If the current_bin is 0, we can't combine anything. Otherwise the last bin (which can only hold
+	//tuples that expect less than 5) is combined with the one before it.
+	if((current_bin != 0) && (current_expectation < 5.0)) {
+		for(long i = (long)small.size() - 1; (i >= 0) && (b->bin[small[i]] == current_bin); i--) {
+			b->bin[small[i]] = current_bin - 1;
+		}
+		b->bin_expectations[current_bin-1] += current_expectation;
+	} else {
+		b->bin_expectations.push_back(current_expectation);
+	}
+}
+
+const struct chi_square_binning &chi_square_bins(const vector<double> &p, const double scale, const bool pairs){
+	static thread_local struct chi_square_binning cache[2];
+	struct chi_square_binning &b = cache[pairs ? 1 : 0];
+
+	if((b.scale == scale) && (b.p == p) && !b.bin.empty()) return b;
+
+	vector<double> e(pairs ? p.size()*p.size() : p.size());
+
+	assert(p.size() <= UINT8_MAX + 1);
+	if(pairs) {
+		// The expected number of occurrences for each possible pair of symbols
+		for(unsigned long i = 0; i < p.size(); i++){
+			for(unsigned long j = 0; j < p.size(); j++){
+				e[(i*p.size()) + j] = p[i] * p[j] * scale;
+			}
+		}
+	} else {
+		for(unsigned long j = 0; j < p.size(); j++) e[j] = p[j] * scale;
+	}
+
+	allocate_bins(e, &b);
+	b.p = p;
+	b.scale = scale;
+
+	return b;
+}
+
+void count_pairs(const byte data[], const long sample_size, const int alphabet_size, vector<long> &pair_counts){
+	const long pairs = sample_size / 2;
+	int shift = 0;
+	long bins, j = 0;
+
+	pair_counts.assign(alphabet_size*alphabet_size, 0);
+
+	while((1 << shift) < alphabet_size) shift++;
+	bins = 1L << (2*shift);
+
+	if(bins > SUB_HISTOGRAM_MAX_BINS) {
+		for(; j < pairs; j++) pair_counts[(data[2*j] * alphabet_size) + data[2*j+1]]++;
+		return;
+	}
+
+	vector<uint32_t> sub(SUB_HISTOGRAMS*bins, 0);
+	uint32_t *h0 = sub.data(), *h1 = h0 + bins, *h2 = h1 + bins, *h3 = h2 + bins;
+
+	for(; j + 4 <= pairs; j += 4){
+		const byte *q = data + 2*j;
+
+		h0[(q[0] << shift) | q[1]]++;
+		h1[(q[2] << shift) | q[3]]++;
+		h2[(q[4] << shift) | q[5]]++;
+		h3[(q[6] << shift) | q[7]]++;
+	}
+
+	for(; j < pairs; j++) h0[(data[2*j] << shift) | data[2*j+1]]++;
+
+	for(int a = 0; a < alphabet_size; a++){
+		for(int b = 0; b < alphabet_size; b++){
+			const long index = (a << shift) | b;
+
+			pair_counts[(a * alphabet_size) + b] = (long)h0[index] + h1[index] + h2[index] + h3[index];
+		}
+	}
+}
+
+void count_bit_tuples(const byte data[], const long sample_size, const int m, vector<int> &occ){
+	const long block_count = sample_size / m;
+	const uint32_t mask = (1U << m) - 1;
+	long i = 0;
+
+	assert((m > 0) && (m <= 16));
+
+	vector<uint32_t> sub(SUB_HISTOGRAMS << m, 0);
+
+#ifdef __SSE2__
+	for(; (i < block_count) && (i*m + 16 <= sample_size); i++){
+		// Move each sample's bit up to the top of its byte
+		const __m128i x = _mm_slli_epi16(_mm_loadu_si128((const __m128i *)(data + i*m)), 7);
+
+		sub[((i % SUB_HISTOGRAMS) << m) + (_mm_movemask_epi8(x) & mask)]++;
+	}
+#endif
+
+	for(; i < block_count; i++){
+		uint32_t reversed = 0;
+
+		for(int j = 0; j < m; j++) reversed |= (uint32_t)(data[i*m + j] & 1) << j;
+		sub[((i % SUB_HISTOGRAMS) << m) + reversed]++;
+	}
+
+	occ.assign(1UL << m, 0);
+	for(uint32_t symbol = 0; symbol < (1U << m); symbol++){
+		uint32_t reversed = 0;
+
+		for(int j = 0; j < m; j++) reversed |= ((symbol >> j) & 1) << (m - 1 - j);
+		for(int h = 0; h < SUB_HISTOGRAMS; h++) occ[symbol] += sub[(h << m) + reversed];
+	}
+}
+
+double calc_T(const vector<double> &bin_expectations, const vector<int> &o){
+	double T = 0.0;
+
+	assert(bin_expectations.size() == o.size());
+	
+	//fprintf(stderr, "nbins: %zu\n", bin_expectations.size());
+
+	for (unsigned int i = 0; i < bin_expectations.size(); i++){
+		//fprintf(stderr, "bin index %u: binCount = %u, binExp = %.17g\n", i, o[i], bin_expectations[i]);
+		T += pow((o[i] - bin_expectations[i]), 2) / bin_expectations[i];
+	}
+
+	return T;
+}
+
+void goodness_of_fit_calc_observed(const byte data[], const vector<int> &bin, vector<int> &o, const int sample_size){
+	for(int j = 0; j < sample_size; j++){
+		o[bin[data[j]]]++;
+	}
+}
+
+void binary_chi_square_independence(const byte data[], double &score, int &df, const int sample_size){
+
+	// Compute proportion of 0s and 1s
+	double p0 = 0.0, p1 = 0.0;
+	unsigned int tuple_count;
+	long ones = 0;
+
+	//The count is exact either way, but an integer sum doesn't wait on each floating point addition
+	for(int i = 0; i < sample_size; i++){
+		ones += data[i];
+	}
+
+	p1 = ((double)ones) / sample_size;
+	p0 = 1.0 - p1;
+
+	// Compute m
+	double min_p = min(p0, p1);
+	int m = 11;
+	int threshhold = 5;
+	while(m > 1){
+		if (pow(min_p, m) * (sample_size / m) >= threshhold){
+			break;
+		}else{
+			m--;
+		}
+	}
+
+	//fprintf(stderr, "chi_square m: %u\n", m);
+	tuple_count = 1 << m;
+
+	if (m < 2){
+		score = 0.0;
+		df = 0;
+		return;
+	}
+
+	// Test is only run if m >= 2
+	double T = 0;
+
+	// Count occurances of m-bit tuples by converting to decimal and using as index in a vector
+	vector<int> occ;
+	int block_count = sample_size / m;
+
+	count_bit_tuples(data, sample_size, m, occ);
+	assert(occ.size() == tuple_count);
+
+	for(unsigned int i = 0; i < occ.size(); i++){
+
+		// GCC only, counts the number of 1s in an integer
+		int w = __builtin_popcount(i);
+
+		double e = pow(p1, w) * pow(p0, m - w) * block_count;
+
+		T += pow(occ[i] - e, 2) / e;
+	}
+
+	score = T;
+	df = pow(2, m) - 2;
+}
+
+void chi_square_independence_from_counts(const vector<double> &p, const vector<long> &pair_counts, double &score, int &df, const int sample_size, const int alphabet_size){
+	// Bin the expected number of occurrences for each possible pair of symbols
+	const struct chi_square_binning &b = chi_square_bins(p, floor(sample_size * 0.5), true);
+
+	// Calculate the observed frequency of each bin
+	vector<int> o(b.bin_expectations.size(), 0);
+	for(unsigned int i = 0; i < b.bin.size(); i++) o[b.bin[i]] += pair_counts[i];
+
+	// Calcualte T 
+	score = calc_T(b.bin_expectations, o);
+
+	// Return score and degrees of freedom
+	df = b.bin_expectations.size() - alphabet_size;
+}
+
+void chi_square_independence(const byte data[], double &score, int &df,  const int sample_size, const int alphabet_size){
+	// Proportion of each element to the entire set
+	vector<double> p(alphabet_size, 0.0);
+	calc_proportions(data, p, sample_size);
+
+	// Count each pair of symbols
+	vector<long> pair_counts;
+	count_pairs(data, sample_size, alphabet_size, pair_counts);
+
+	chi_square_independence_from_counts(p, pair_counts, score, df, sample_size, alphabet_size);
+}
+
+void independence_counts_init(struct independence_counts *c, const byte data[], const long len, const int alphabet_size){
+	int k = alphabet_size;
+
+	c->start = 0;
+	c->len = len;
+	c->alphabet_size = k;
+	c->symbol_counts.assign(k, 0);
+	c->pair_counts[0].assign(k*k, 0);
+	c->pair_counts[1].assign(k*k, 0);
+
+	for(long i = 0; i < len; i++) c->symbol_counts[data[i]]++;
+	for(long j = 0; j+1 < len; j++) c->pair_counts[j % 2][(data[j] * k) + data[j+1]]++;
+}
+
+void independence_counts_slide(struct independence_counts *c, const byte window[], const long stride){
+	long len = c->len;
+	int k = c->alphabet_size;
+
+	assert(stride <= len);
+
+	for(long i = 0; i < stride; i++) {
+		c->symbol_counts[window[i]]--;
+		c->symbol_counts[window[len + i]]++;
+	}
+
+	// Drop the pairs that start before the new window, and add the pairs that end within it
+	for(long j = 0; (j < stride) && (j+1 < len); j++) c->pair_counts[(c->start + j) % 2][(window[j] * k) + window[j+1]]--;
+	for(long j = max(len - 1, stride); j+1 < len + stride; j++) c->pair_counts[(c->start + j) % 2][(window[j] * k) + window[j+1]]++;
+
+	c->start += stride;
+}
+
+void chi_square_independence_incremental(const struct independence_counts *c, double &score, int &df){
+	vector<double> p(c->alphabet_size);
+	int present = 0;
+
+	for(int i = 0; i < c->alphabet_size; i++) {
+		p[i] = ((double)c->symbol_counts[i]) / ((double)c->len);
+		if(c->symbol_counts[i] > 0) present++;
+	}
+
+	// The symbols aren't translated, so the degrees of freedom only count those that occur in the window
+	chi_square_independence_from_counts(p, c->pair_counts[c->start % 2], score, df, c->len, present);
+}
+
+void binary_goodness_of_fit(const byte data[], double &score, int &df, const int sample_size){
+
+	// Find proportion of 1s to the whole data set
+	int sublength = sample_size / 10;
+	int ones = 0;
+
+	for(int i = 0; i < sample_size; i++){
+		ones += data[i];
+	}
+
+	double p = divide(ones, sample_size);
+	double T = 0;
+
+	// Compute expected 0s and 1s in each sub-sequence
+	double e0 = (1.0 - p) * sublength;
+	double e1 = p * sublength;
+
+	for(int i = 0; i < 10; i++){
+
+		// Count actual 0s and 1s in each sub-sequence
+		int o0 = 0, o1 = 0;
+
+		for(int j = 0; j < sublength; j++){
+			o1 += data[i*sublength + j];
+		}
+
+		o0 = sublength - o1;
+
+		// Compute T
+		T += (pow(o0 - e0, 2) / e0) + (pow(o1 - e1, 2) / e1);
+	}
+
+	score = T;
+	df = 9;
+}
+
+void goodness_of_fit(const byte data[], double &score, int &df, const int sample_size, const int alphabet_size){
+	vector<double> p(alphabet_size, 0.0);
+	calc_proportions(data, p, sample_size);
+
+	// Bin the expected number of occurrences of each symbol in each subset
+	const struct chi_square_binning &b = chi_square_bins(p, floor((double) sample_size / 10.0), false);
+
+	// Calculate the observed frequency of each symbol in each subset
+	int block_size = sample_size/10;
+	double T = 0.0;
+	vector<int> o(b.bin_expectations.size());
+
+	for(int j=0; j<10; j++) {
+		for(unsigned int i=0; i<o.size(); i++) o[i] = 0;
+		goodness_of_fit_calc_observed(data+j*block_size, b.bin, o, block_size);
+		T += calc_T(b.bin_expectations, o);
+	}
+
+	// Return score and degrees of freedom
+	score = T;
+	df = 9*(b.bin_expectations.size()-1);
+}
+
+bool chi_square_tests(const byte data[], const int sample_size, const int alphabet_size, const int verbose){
+	ProfileScope profile("chi_square_tests", NULL, sample_size);
+
+	double score = 0.0;
+	double pvalue;
+	int df = 0;
+
+	// Chi Square independence test
+	if(alphabet_size == 2){
+		binary_chi_square_independence(data, score, df, sample_size);
+	}else{
+		chi_square_independence(data, score, df, sample_size, alphabet_size);
+	}
+
+	pvalue = chi_square_pvalue(score, df);
+
+	// Print results
+	if(verbose){
+		printf("Chi square independence\n");
+		printf("\tscore = %f\n", score);
+		printf("\tdegrees of freedom = %d\n", df);
+		printf("\tp-value = %f\n\n", pvalue);
+	}
+
+	// Check result to return if test failed
+	if(pvalue < 0.001){
+		return false;
+	}
+
+	// Reset score and df
+	score = 0.0;
+	df = 0;
+
+	// Chi Square goodness of fit test
+	if(alphabet_size == 2){
+		binary_goodness_of_fit(data, score, df, sample_size);
+	}else{
+		goodness_of_fit(data, score, df, sample_size, alphabet_size);
+	}
+
+	pvalue = chi_square_pvalue(score, df);
+
+	// Print results
+	if(verbose){
+		printf("Chi square goodness of fit\n");
+		printf("\tscore = %f\n", score);
+		printf("\tdegrees of freedom = %d\n", df);
+		printf("\tp-value = %f\n\n", pvalue);
+	}
+
+	// Check result to return if test failed
+	if(pvalue < 0.001){
+		return false;
+	}
+
+	return true;
+}
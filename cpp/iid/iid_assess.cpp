@@ -0,0 +1,20 @@
+#include "iid_assess.h"
+
+void iid_assess(const data_t *data, bool initial_entropy, struct iid_result *result, struct arena *scratch, const uint64_t *key) {
+	double rawmean, median;
+
+	calc_stats(data, rawmean, median);
+
+	result->H_original = data->word_size;
+	result->H_bitstring = 1.0;
+	if(initial_entropy) result->H_original = most_common(data->symbols, data->len, data->alph_size, 0, "Literal");
+	if((data->alph_size > 2) || !initial_entropy) result->H_bitstring = most_common(data->bsymbols, data->blen, 2, 0, "Bitstring");
+
+	result->h_assessed = data->word_size;
+	if((data->alph_size > 2) || !initial_entropy) result->h_assessed = min(result->h_assessed, result->H_bitstring * data->word_size);
+	if(initial_entropy) result->h_assessed = min(result->h_assessed, result->H_original);
+
+	result->chi_square_test_pass = chi_square_tests(data->symbols, data->len, data->alph_size, 0);
+	result->len_LRS_test_pass = len_LRS_test(data->symbols, data->len, data->alph_size, 0, "Literal", scratch);
+	result->perm_test_pass = permutation_tests(data, rawmean, median, 0, true, key);
+}
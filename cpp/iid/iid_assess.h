@@ -0,0 +1,21 @@
+#pragma once
+#include "../shared/utils.h"
+#include "../shared/most_common.h"
+#include "../shared/lrs_test.h"
+#include "permutation_tests.h"
+#include "chi_square_tests.h"
+
+//The results of an IID assessment
+struct iid_result {
+	double H_original;
+	double H_bitstring;
+	double h_assessed;
+	bool chi_square_test_pass;
+	bool len_LRS_test_pass;
+	bool perm_test_pass;
+};
+
+//Runs the MCV estimate and the IID tests on already loaded data, without any reporting. The LRS
+//test's scratch memory comes from scratch if it is given; the permutation tests use their own per thread.
+//The permutations are drawn from *key, or from /dev/urandom if key is NULL.
+void iid_assess(const data_t *data, bool initial_entropy, struct iid_result *result, struct arena *scratch = NULL, const uint64_t *key = NULL);
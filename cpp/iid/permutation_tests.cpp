@@ -0,0 +1,601 @@
+#include "permutation_tests.h"
+#include "../shared/profile.h"
+#include "../shared/progress.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+byte *conversion1(const byte data[], const int sample_size, struct arena *scratch){
+	byte *ret = arena_array<byte>(scratch, conversion_len(sample_size));
+
+	memset(ret, 0, conversion_len(sample_size));
+	for(int i = 0; i < sample_size; ++i){
+		ret[i/8] += data[i];	// integer division to ensure the size of ret is sample_size / 8
+	}
+
+	return ret;
+}
+
+byte *conversion2(const byte data[], const int sample_size, struct arena *scratch){
+	byte *ret = arena_array<byte>(scratch, conversion_len(sample_size));
+
+	memset(ret, 0, conversion_len(sample_size));
+	for(int i = 0; i < sample_size; ++i) {
+		ret[i/8] += data[i] << (7 - i%8);
+	}
+
+	return ret;
+}
+
+double excursion(const byte data[], const double rawmean, const int sample_size){
+	double d_i = 0;
+	double max = 0;
+	double running_sum = 0;
+
+	for(int i = 0; i < sample_size; ++i){
+		running_sum += data[i];
+		d_i = abs(running_sum - ((i+1) * rawmean));
+
+		if(d_i > max){
+			max = d_i;
+		}
+	}
+
+	return max;
+}
+
+void directional_runs(const byte data[], const int sample_size, struct sign_runs *s){
+	const unsigned int len = (sample_size > 0) ? sample_size - 1 : 0;
+
+	sign_runs_init(s);
+
+	for(unsigned int i = 0; i < len; i += 64){
+		unsigned int count = min(64U, len - i);
+		uint64_t word = 0;
+
+		for(unsigned int j = 0; j < count; j++) word |= (uint64_t)(data[i+j] > data[i+j+1]) << j;
+		sign_runs_add(s, word, count);
+	}
+}
+
+void median_runs(const byte data[], const double median, const int sample_size, struct sign_runs *s){
+	sign_runs_init(s);
+
+	for(int i = 0; i < sample_size; i += 64){
+		unsigned int count = min(64, sample_size - i);
+		uint64_t word = 0;
+
+		for(unsigned int j = 0; j < count; j++) word |= (uint64_t)(data[i+j] < median) << j;
+		sign_runs_add(s, word, count);
+	}
+}
+
+unsigned int num_increases_decreases(const struct sign_runs *s, const unsigned int len){
+	unsigned int increases = len - s->negatives;
+
+	return max(increases, s->negatives);
+}
+
+void find_collisions(const byte data[], const unsigned int n, unsigned int &count, unsigned int &total, unsigned int &longest){
+	unsigned int start = 0;
+
+	count = 0;
+	total = 0;
+	longest = 0;
+
+	while(start < n){
+		uint64_t seen[4] = {0, 0, 0, 0};
+		unsigned int i;
+
+		// Progressively increase the number of elements checked, until one has been seen before
+		for(i = start; i < n; i++){
+			const byte symbol = data[i];
+			const uint64_t bit = 1ULL << (symbol & 63);
+
+			if(seen[symbol >> 6] & bit) break;
+			seen[symbol >> 6] |= bit;
+		}
+
+		// The samples after the last collision don't form one
+		if(i == n) break;
+
+		// Record info on collision and start again past its end
+		count++;
+		total += i - start;
+		if(i - start > longest) longest = i - start;
+		start = i + 1;
+	}
+}
+
+// The number of blocks that the vector kernels add into their 32-bit covariance lanes before moving
+// them into the 64-bit totals. Each block adds at most 4*255*255 to a lane, so this can't overflow.
+#define LAG_FLUSH_BLOCKS 4096
+
+#ifdef __SSE2__
+// The lag statistics for the samples i < the returned value, which is a multiple of 16, using the baseline
+// instruction set. Each 16 byte block of samples is loaded once and compared with, and multiplied by, the
+// block at each lag: the equal bytes are counted with movemask and popcount, and the products are summed
+// by widening to 16 bits and using madd.
+static unsigned int lag_stats_sse2(const byte data[], const unsigned int n, unsigned int T_per[NUM_LAGS], unsigned long int T_cov[NUM_LAGS]){
+	const __m128i zero = _mm_setzero_si128();
+	__m128i acc[NUM_LAGS];
+	unsigned int i, blocks = 0;
+
+	for(int k = 0; k < NUM_LAGS; k++) acc[k] = _mm_setzero_si128();
+
+	for(i = 0; i + 16 + lags[NUM_LAGS-1] <= n; i += 16){
+		__m128i x = _mm_loadu_si128((const __m128i *)(data + i));
+		__m128i x_lo = _mm_unpacklo_epi8(x, zero);
+		__m128i x_hi = _mm_unpackhi_epi8(x, zero);
+
+		for(int k = 0; k < NUM_LAGS; k++){
+			__m128i y = _mm_loadu_si128((const __m128i *)(data + i + lags[k]));
+
+			T_per[k] += __builtin_popcount((unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)));
+			acc[k] = _mm_add_epi32(acc[k], _mm_add_epi32(_mm_madd_epi16(x_lo, _mm_unpacklo_epi8(y, zero)), _mm_madd_epi16(x_hi, _mm_unpackhi_epi8(y, zero))));
+		}
+
+		if(++blocks == LAG_FLUSH_BLOCKS || i + 32 + lags[NUM_LAGS-1] > n){
+			for(int k = 0; k < NUM_LAGS; k++){
+				uint32_t lanes[4];
+
+				_mm_storeu_si128((__m128i *)lanes, acc[k]);
+				for(int l = 0; l < 4; l++) T_cov[k] += lanes[l];
+				acc[k] = _mm_setzero_si128();
+			}
+			blocks = 0;
+		}
+	}
+
+	return i;
+}
+#endif
+
+#ifdef CPU_DISPATCH
+// As lag_stats_sse2, with 32 byte blocks.
+TARGET_AVX2 static unsigned int lag_stats_avx2(const byte data[], const unsigned int n, unsigned int T_per[NUM_LAGS], unsigned long int T_cov[NUM_LAGS]){
+	__m256i acc[NUM_LAGS];
+	unsigned int i, blocks = 0;
+
+	for(int k = 0; k < NUM_LAGS; k++) acc[k] = _mm256_setzero_si256();
+
+	for(i = 0; i + 32 + lags[NUM_LAGS-1] <= n; i += 32){
+		__m256i x = _mm256_loadu_si256((const __m256i *)(data + i));
+		__m256i x_lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(x));
+		__m256i x_hi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(x, 1));
+
+		for(int k = 0; k < NUM_LAGS; k++){
+			__m256i y = _mm256_loadu_si256((const __m256i *)(data + i + lags[k]));
+			__m256i y_lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(y));
+			__m256i y_hi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(y, 1));
+
+			T_per[k] += __builtin_popcount((unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+			acc[k] = _mm256_add_epi32(acc[k], _mm256_add_epi32(_mm256_madd_epi16(x_lo, y_lo), _mm256_madd_epi16(x_hi, y_hi)));
+		}
+
+		if(++blocks == LAG_FLUSH_BLOCKS || i + 64 + lags[NUM_LAGS-1] > n){
+			for(int k = 0; k < NUM_LAGS; k++){
+				uint32_t lanes[8];
+
+				_mm256_storeu_si256((__m256i *)lanes, acc[k]);
+				for(int l = 0; l < 8; l++) T_cov[k] += lanes[l];
+				acc[k] = _mm256_setzero_si256();
+			}
+			blocks = 0;
+		}
+	}
+
+	return i;
+}
+
+// As lag_stats_avx2, with 64 byte blocks. The comparisons give a mask directly, so no movemask is needed.
+TARGET_AVX512 static unsigned int lag_stats_avx512(const byte data[], const unsigned int n, unsigned int T_per[NUM_LAGS], unsigned long int T_cov[NUM_LAGS]){
+	__m512i acc[NUM_LAGS];
+	unsigned int i, blocks = 0;
+
+	for(int k = 0; k < NUM_LAGS; k++) acc[k] = _mm512_setzero_si512();
+
+	for(i = 0; i + 64 + lags[NUM_LAGS-1] <= n; i += 64){
+		__m512i x = _mm512_loadu_si512((const void *)(data + i));
+		__m512i x_lo = _mm512_cvtepu8_epi16(_mm512_castsi512_si256(x));
+		__m512i x_hi = _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(x, 1));
+
+		for(int k = 0; k < NUM_LAGS; k++){
+			__m512i y = _mm512_loadu_si512((const void *)(data + i + lags[k]));
+			__m512i y_lo = _mm512_cvtepu8_epi16(_mm512_castsi512_si256(y));
+			__m512i y_hi = _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(y, 1));
+
+			T_per[k] += __builtin_popcountll(_mm512_cmpeq_epi8_mask(x, y));
+			acc[k] = _mm512_add_epi32(acc[k], _mm512_add_epi32(_mm512_madd_epi16(x_lo, y_lo), _mm512_madd_epi16(x_hi, y_hi)));
+		}
+
+		if(++blocks == LAG_FLUSH_BLOCKS || i + 128 + lags[NUM_LAGS-1] > n){
+			for(int k = 0; k < NUM_LAGS; k++){
+				uint32_t lanes[16];
+
+				_mm512_storeu_si512((void *)lanes, acc[k]);
+				for(int l = 0; l < 16; l++) T_cov[k] += lanes[l];
+				acc[k] = _mm512_setzero_si512();
+			}
+			blocks = 0;
+		}
+	}
+
+	return i;
+}
+#endif
+
+void lag_stats(const byte data[], const unsigned int n, unsigned int T_per[NUM_LAGS], unsigned long int T_cov[NUM_LAGS]){
+	unsigned int i = 0;
+
+	assert(n >= lags[NUM_LAGS-1]);
+
+	for(int k = 0; k < NUM_LAGS; k++){
+		T_per[k] = 0;
+		T_cov[k] = 0;
+	}
+
+#ifdef CPU_DISPATCH
+	if(cpu_isa() >= CPU_ISA_AVX512) i = lag_stats_avx512(data, n, T_per, T_cov);
+	else if(cpu_isa() >= CPU_ISA_AVX2) i = lag_stats_avx2(data, n, T_per, T_cov);
+	else i = lag_stats_sse2(data, n, T_per, T_cov);
+#elif defined(__SSE2__)
+	i = lag_stats_sse2(data, n, T_per, T_cov);
+#endif
+
+	// All five lags are in range until the last lags[NUM_LAGS-1] samples
+	for(; i + lags[NUM_LAGS-1] < n; ++i){
+		for(int k = 0; k < NUM_LAGS; k++){
+			T_per[k] += (data[i] == data[i+lags[k]]);
+			T_cov[k] += data[i] * data[i+lags[k]];
+		}
+	}
+
+	for(int k = 0; k < NUM_LAGS; k++){
+		for(unsigned int j = i; j < n-lags[k]; ++j){
+			T_per[k] += (data[j] == data[j+lags[k]]);
+			T_cov[k] += data[j] * data[j+lags[k]];
+		}
+	}
+}
+
+unsigned int compression(const byte data[], const int sample_size, const byte max_symbol, struct arena *scratch){
+	char buffer[5];
+	char *msg;
+	unsigned int curlen = 0;
+	char *curmsg;
+
+	assert(max_symbol > 0);
+
+	// Build string of bytes
+	// Reserve the necessary size sample_size*(floor(log10(max_symbol))+2)
+	// This is "worst case" and accounts for the space at the end of the number, as well.
+	msg = arena_array<char>(scratch, compression_msg_len(sample_size, max_symbol));
+	msg[0] = '\0';
+	curmsg = msg;
+
+	for(int i = 0; i < sample_size; ++i) {
+		int res;
+		res = sprintf(curmsg, "%u ", data[i]);
+		assert(res >= 2);
+		curlen += res;
+		curmsg += res;
+	}
+
+	if(curlen > 0) {
+		// Remove the extra ' ' at the end
+		assert(curmsg > msg);
+		curmsg--;
+		*curmsg = '\0';
+		curlen--;
+	}
+
+	// Set up structures for compression
+	unsigned int dest_len = ceil(1.01*curlen) + 600;
+	char* dest = arena_array<char>(scratch, dest_len);
+
+	// Compress and capture the size of the compressed data
+	int rc = BZ2_bzBuffToBuffCompress(dest, &dest_len, msg, curlen, 5, 0, 0);
+
+	// Return with proper return code
+	if(rc == BZ_OK){
+		return dest_len;
+	}else{
+		return 0;
+	}
+}
+
+void excursion_test(const byte data[], const double rawmean, const int sample_size, long double* stats, const bool *test_status){
+
+	if(test_status[0]) stats[0] = excursion(data, rawmean, sample_size);
+}
+
+void directional_tests(const byte data[], const int alphabet_size, const int sample_size, long double *stats, const bool *test_status, struct arena *scratch){
+
+	if(test_status[1] || test_status[2] || test_status[3]) {
+		ScratchScope scope(scratch, 0);
+		struct sign_runs runs;
+		unsigned int alt_len;
+
+		if(alphabet_size == 2){
+			byte *cs1 = conversion1(data, sample_size, scope.get());
+			alt_len = conversion_len(sample_size) - 1;		// conversion1 reduces the total size by a factor of 8
+			directional_runs(cs1, conversion_len(sample_size), &runs);
+		}else{
+			alt_len = sample_size - 1;
+			directional_runs(data, sample_size, &runs);
+		}
+
+		if(test_status[1]) stats[1] = runs.num_runs;
+		if(test_status[2]) stats[2] = runs.longest_run;
+		if(test_status[3]) stats[3] = num_increases_decreases(&runs, alt_len);
+	}
+}
+
+void consecutive_runs_tests(const byte data[], const double median, const int alphabet_size, const int sample_size, long double *stats, const bool *test_status){
+
+	if(test_status[4] || test_status[5]) {
+		struct sign_runs runs;
+
+		if(alphabet_size == 2){
+			median_runs(data, 0.5, sample_size, &runs);
+		}else{
+			median_runs(data, median, sample_size, &runs);
+		}
+
+		if(test_status[4]) stats[4] = runs.num_runs;
+		if(test_status[5]) stats[5] = runs.longest_run;
+	}
+}
+
+void collision_tests(const byte data[], const int alphabet_size, const int sample_size, long double *stats, const bool *test_status, struct arena *scratch){
+
+	if(test_status[7] || test_status[6]) {
+		ScratchScope scope(scratch, 0);
+		unsigned int col_count, col_total, col_max;
+
+		if(alphabet_size == 2){
+			byte *cs2 = conversion2(data, sample_size, scope.get());
+			find_collisions(cs2, conversion_len(sample_size), col_count, col_total, col_max);		// conversion2 reduces the total size by a factor of 8
+		}else{
+			find_collisions(data, sample_size, col_count, col_total, col_max);
+		}
+
+		// 5.1.7 Average Collision Test and 5.1.8 Maximum Collision Test
+		if(test_status[6]) stats[6] = divide(col_total, col_count);
+		if(test_status[7]) stats[7] = col_max;
+	}
+}
+
+void lag_tests(const byte data[], const int alphabet_size, const int sample_size, long double *stats, const bool *test_status, struct arena *scratch){
+	bool any = false;
+
+	for(int k = 0; k < 2*NUM_LAGS; k++) any = any || test_status[8+k];
+
+	if(any) {
+		ScratchScope scope(scratch, 0);
+		unsigned int T_per[NUM_LAGS];
+		unsigned long int T_cov[NUM_LAGS];
+
+		if(alphabet_size == 2){
+			byte *cs1 = conversion1(data, sample_size, scope.get());
+			lag_stats(cs1, conversion_len(sample_size), T_per, T_cov);
+		}else{
+			lag_stats(data, sample_size, T_per, T_cov);
+		}
+
+		for(int k = 0; k < NUM_LAGS; k++){
+			if(test_status[8+k]) stats[8+k] = T_per[k];
+			if(test_status[8+NUM_LAGS+k]) stats[8+NUM_LAGS+k] = T_cov[k];
+		}
+	}
+}
+
+void compression_test(const byte data[], const int sample_size, long double *stats, const byte max_symbol, const bool *test_status, struct arena *scratch){
+
+	if(test_status[18]) {
+		ScratchScope scope(scratch, 0);
+		stats[18] = compression(data, sample_size, max_symbol, scope.get());
+	}
+}
+
+size_t permutation_scratch_size(const data_t *dp){
+	size_t msg_len = compression_msg_len(dp->len, dp->maxsymbol);
+	size_t compression_size = arena_round(msg_len) + arena_round(ceil(1.01*msg_len) + 600);
+	size_t conversion_size = arena_round(conversion_len(dp->len));
+
+	return max(shuffle_scratch_size(dp->len), max(compression_size, conversion_size));
+}
+
+void run_tests(const data_t *dp, const byte data[], const byte rawdata[], const double rawmean, const double median, long double *stats, const bool *test_status, struct arena *scratch){
+
+	// Perform tests
+	excursion_test(rawdata, rawmean, dp->len, stats, test_status);
+	directional_tests(data, dp->alph_size, dp->len, stats, test_status, scratch);
+	consecutive_runs_tests(data, median, dp->alph_size, dp->len, stats, test_status);
+	collision_tests(data, dp->alph_size, dp->len, stats, test_status, scratch);
+	if(dp->alph_size == 2) {
+		//The two conversions only make sense if the two symbols are 0 and 1.
+		lag_tests(data, dp->alph_size, dp->len, stats, test_status, scratch);
+	} else {
+		//The covariance uses the raw sample values. The periodicity is the same for either, as the
+		//translation to symbols keeps equal samples equal and distinct ones distinct.
+		lag_tests(rawdata, dp->alph_size, dp->len, stats, test_status, scratch);
+	}
+	compression_test(rawdata, dp->len, stats, dp->maxsymbol, test_status, scratch);
+}
+
+void print_results(int C[][3]){
+	cout << endl << endl;
+	cout << "                statistic  C[i][0]  C[i][1]  C[i][2]" << endl;
+	cout << "----------------------------------------------------" << endl;
+	for(unsigned int i = 0; i < num_tests; ++i){
+		if((C[i][0] + C[i][1] <= 5) || C[i][1] + C[i][2] <= 5){
+			cout << setw(24) << test_names[i] << "*";
+		}else{
+			cout << setw(25) << test_names[i];
+		}
+		cout << setw(8) << C[i][0];
+		cout << setw(8) << C[i][1];
+		cout << setw(8) << C[i][2] << endl;
+	}
+	cout << "(* denotes failed test)" << endl;
+	cout << endl;
+}
+
+bool permutation_tests(const data_t *dp, const double rawmean, const double median, const int verbose, const bool quiet, const uint64_t *key){
+	ProfileScope profile("permutation_tests", NULL, dp->len, true);
+	uint64_t permutationKey;
+	byte raw_symbol[256];
+	long tested = 0;	// the permutations that were run rather than skipped
+
+	// Counters for the pass/fail of each statistic
+	int C[num_tests][3];
+
+	// Original test results (t) 
+	long double t[num_tests];
+	bool test_status[num_tests];
+
+	// Each permutation's results, held until the results of every earlier permutation have been counted
+	vector<array<long double, num_tests> > results(PERMS);
+	vector<bool> finished(PERMS, false);
+	int next_to_count = 0;
+	int passed_count = 0;
+
+	// Build map of results
+	for(unsigned int i = 0; i < num_tests; ++i){
+		C[i][0] = 0;
+		C[i][1] = 0;
+		C[i][2] = 0;
+
+		t[i] = -1;
+		test_status[i] = true;
+	}
+
+	// Run initial tests
+	if(!quiet) cout << "Beginning initial tests..." << endl;
+
+	if(key != NULL) {
+		permutationKey = *key;
+	} else {
+		uint64_t xoshiro256starstarMainSeed[4];
+
+		//Without a seed the permutations can't be drawn, so the data can't be shown to be IID. The callers check
+		//that the random source can be read before the tests are run, so this is only reached if the source fails in the meantime.
+		if(!seed(xoshiro256starstarMainSeed)) return false;
+		permutationKey = xoshiro256starstarMainSeed[0];
+	}
+
+	{
+		ScratchScope scope(NULL, permutation_scratch_size(dp));
+		run_tests(dp, dp->symbols, dp->rawsymbols, rawmean, median, t, test_status, scope.get());
+	}
+
+	if(verbose){
+		cout << endl << "Initial test results" << endl;
+		for(unsigned int i = 0; i < num_tests; i++){
+			cout << setw(23) << test_names[i] << ": ";
+			cout << t[i] << endl;
+		}
+		cout << endl;
+		cout << "Permutation seed: " << permutationKey << endl << endl;
+	}
+	
+	if(!quiet) cout << "Beginning permutation tests... these may take some time" << endl;
+
+	//The progress is reported from a separate thread, so the permutations never wait on the output
+	ProgressReporter progress("Permutation tests", PERMS, num_tests, omp_get_max_threads(), (verbose && !quiet) || progress_requested());
+
+	//The translation from the raw samples to symbols is one to one, so only the symbols are shuffled,
+	//and the raw samples are rebuilt from them with this table.
+	memset(raw_symbol, 0, sizeof(raw_symbol));
+	for(long i = 0; i < dp->len; ++i) raw_symbol[dp->symbols[i]] = dp->rawsymbols[i];
+
+	#pragma omp parallel
+	{
+		byte *data;
+		byte *rawdata;
+		struct random_stream rs;
+		bool run_status[num_tests];
+		//Each thread's scratch memory is allocated once, and reused by every permutation it tests
+		struct arena scratch;
+
+		arena_init(&scratch, permutation_scratch_size(dp));
+		data = new byte[dp->len];
+		rawdata = new byte[dp->len];
+
+		//The permutations are handed out in order, so that their results can be counted soon after they finish
+		#pragma omp for schedule(dynamic)
+		for(int i = 0; i < PERMS; ++i) {
+			bool skip;
+
+			//The statistics that are still undecided. Counting in order means that a statistic
+			//that is decided now was decided by earlier permutations, so it would not be counted for this one.
+			#pragma omp critical(resultUpdate)
+			{
+				skip = (passed_count == (int)num_tests);
+				memcpy(run_status, test_status, sizeof(run_status));
+			}
+
+			if(!skip) {
+				progress.started(omp_get_thread_num());
+				//Each permutation is of the original data, using the variates for its own index
+				memcpy(data, dp->symbols, dp->len);
+				random_stream_init_keyed(&rs, permutationKey, i);
+				bucket_shuffle(data, dp->len, &rs, &scratch);
+				for(long j = 0; j < dp->len; ++j) rawdata[j] = raw_symbol[data[j]];
+				run_tests(dp, data, rawdata, rawmean, median, results[i].data(), run_status, &scratch);
+			}
+
+			// Aggregate results into the counters, in the order of the permutations
+			#pragma omp critical(resultUpdate)
+			{
+				finished[i] = true;
+				while((next_to_count < PERMS) && finished[next_to_count]) {
+					if(passed_count < (int)num_tests) {
+						const long double *tp = results[next_to_count].data();
+
+						for(unsigned int j = 0; j < num_tests; ++j){
+							if(test_status[j]) {
+								if(tp[j] > t[j]){
+									C[j][0]++;
+								} else if(tp[j] == t[j]){
+									C[j][1]++;
+								} else {
+									C[j][2]++;
+								}
+								if((C[j][0] + C[j][1] > 5) && (C[j][1] + C[j][2] > 5)) {
+									test_status[j] = false;
+								}
+							}
+						}
+						passed_count = 0;
+						for(unsigned int j=0; j < num_tests; j++) if(!test_status[j]) passed_count++;
+					}
+					next_to_count++;
+				}
+				if(!skip) tested++;
+				progress.set_resolved(passed_count);
+			} // end resultUpdate
+
+			progress.finished(omp_get_thread_num());
+		}
+        	delete[](data);
+        	delete[](rawdata);
+		arena_free(&scratch);
+	} //end parallel
+
+	progress.stop();
+	profile.add_permutations(tested);
+
+	if(verbose) print_results(C);
+
+	for(unsigned int i = 0; i < num_tests; ++i){
+		if((C[i][0] + C[i][1] <= 5) || (C[i][1] + C[i][2] <= 5)){
+			return false;
+	 	}
+	}
+
+	return true;
+}
@@ -3,14 +3,19 @@
 #include "shared/lrs_test.h"
 #include "iid/permutation_tests.h"
 #include "iid/chi_square_tests.h"
+#include "iid/iid_assess.h"
+#include "shared/stream.h"
+#include "shared/profile.h"
+#include "shared/progress.h"
 #include <omp.h>
 #include <getopt.h>
 #include <limits.h>
+#include <errno.h>
 
 
 
 [[ noreturn ]] void print_usage(){
-	printf("Usage is: ea_iid [-i|-c] [-a|-t] [-v] [-l <index>,<samples> ] <file_name> [bits_per_symbol]\n\n");
+	printf("Usage is: ea_iid [-i|-c] [-a|-t] [-v] [-l <index>,<samples> ] [--seed <seed>] [--profile <file>] [--progress <destination>] <file_name> [bits_per_symbol]\n\n");
 	printf("\t <file_name>: Must be relative path to a binary file with at least 1 million entries (samples).\n");
 	printf("\t [bits_per_symbol]: Must be between 1-8, inclusive. By default this value is inferred from the data.\n");
 	printf("\t [-i|-c]: '-i' for initial entropy estimate, '-c' for conditioned sequential dataset entropy estimate. The initial entropy estimate is the default.\n");
@@ -18,6 +23,24 @@
 	printf("\t Note: When testing binary data, no `H_bitstring` assessment is produced, so the `-a` and `-t` options produce the same results for the initial assessment of binary data.\n");
 	printf("\t -v: Optional verbosity flag for more output. Can be used multiple times.\n");
 	printf("\t -l <index>,<samples>\tRead the <index> substring of length <samples>.\n");
+	printf("\t -l <first>-<last>,<samples> or -l all,<samples>: Sweep the substrings <first> to <last> (or all of them),\n");
+	printf("\t printing one result line per substring. -l may be given several times to sweep a list of substrings.\n");
+	printf("\t The substrings are assessed in one process, <threads> at a time (see -j).\n");
+	printf("\t -w <window>: Streaming mode. Assess successive windows of <window> samples read from <file_name>\n");
+	printf("\t (or standard input for '-'), printing one result line per window.\n");
+	printf("\t -s <stride>: In streaming mode, the number of samples between the starts of successive windows.\n");
+	printf("\t By default, the windows don't overlap.\n");
+	printf("\t -f: In streaming mode, follow a growing file, waiting for more samples at the end of the file rather than stopping.\n");
+	printf("\t -j <threads>: In streaming or sweep mode, the number of windows assessed at once (default 1; the permutation tests are already parallel).\n");
+	printf("\t -q <depth>: In streaming mode, the number of windows read ahead of the assessment (default 1).\n");
+	printf("\t --seed <seed>: Draw the permutations from this 64-bit seed rather than from /dev/urandom, so that the\n");
+	printf("\t permutation test results can be reproduced (with any number of threads). With -v, the seed used is printed.\n");
+	printf("\t --profile <file>: Append a JSON record of the time, memory and work taken by each estimator and phase\n");
+	printf("\t of the run to <file> ('-' for standard error). Setting EA_PROFILE to a file name does the same.\n");
+	printf("\t --progress <destination>: Report the progress of the permutation tests (the permutations per second, the\n");
+	printf("\t statistics resolved, the time left and how busy each thread is) to a file, '-' for standard output,\n");
+	printf("\t tcp:<host>:<port> or unix:<path>. With -v, the progress is reported to standard output.\n");
+	printf("\t --progress-interval <ms>: The time between progress reports (default %d ms).\n", PROGRESS_INTERVAL_MS);
 	printf("\n");
 	printf("\t Samples are assumed to be packed into 8-bit values, where the least significant 'bits_per_symbol'\n");
 	printf("\t bits constitute the symbol.\n");
@@ -41,6 +64,44 @@
 	exit(-1);
 }
 
+//The settings shared by every window in streaming mode
+struct iid_stream_context {
+	int word_size;
+	bool initial_entropy;
+	bool all_bits;
+	const uint64_t *key;	// the permutation seed, or NULL to draw one for each window
+};
+
+void iid_assess_window(const struct stream_window *window, void *context, char *record, size_t record_len) {
+	struct iid_stream_context *settings = (struct iid_stream_context *)context;
+	struct iid_result result;
+	long first = window->offset;
+	long last = window->offset + (long)window->samples.size() - 1;
+	data_t data;
+
+	data.word_size = settings->word_size;
+	if(!read_buffer(window->samples.data(), window->samples.size(), &data)){
+		snprintf(record, record_len, "Window %ld (samples %ld-%ld): Error reading samples", window->index, first, last);
+		return;
+	}
+
+	if(data.alph_size <= 1){
+		snprintf(record, record_len, "Window %ld (samples %ld-%ld): Symbol alphabet consists of 1 symbol. No entropy awarded", window->index, first, last);
+		free_data(&data);
+		return;
+	}
+
+	if(!settings->all_bits && (data.blen > MIN_SIZE)) data.blen = MIN_SIZE;
+
+	iid_assess(&data, settings->initial_entropy, &result, NULL, settings->key);
+
+	snprintf(record, record_len, "Window %ld (samples %ld-%ld): H_original = %.17g, H_bitstring = %.17g, Assessed min entropy: %.17g, chi square tests %s, LRS test %s, permutation tests %s",
+		window->index, first, last, result.H_original, result.H_bitstring, result.h_assessed,
+		result.chi_square_test_pass ? "passed" : "failed", result.len_LRS_test_pass ? "passed" : "failed", result.perm_test_pass ? "passed" : "failed");
+
+	free_data(&data);
+}
+
 int main(int argc, char* argv[]){
 
 	bool initial_entropy, all_bits;
@@ -51,14 +112,34 @@ int main(int argc, char* argv[]){
 	int opt;
 	unsigned long subsetIndex = ULONG_MAX;
 	unsigned long subsetSize = 0;
-	unsigned long long inint;
-	char *nextOption;
+	struct slice_range range;
+	vector<struct slice_range> ranges;
+	struct iid_stream_context settings;
+	long window_len = 0, stride = 0, queue_depth = 1;
+	int worker_count = 1;
+	bool follow = false;
+	uint64_t key;
+	uint64_t probe[4];
+	bool seeded = false;
+	const char *profile_path = NULL;
+	const char *progress_destination = NULL;
+	long progress_interval = 0;
+	bool loaded;
+	char *end;
+	//The long options only; their values are outside the range of the short options' characters
+	static const struct option long_options[] = {
+		{"seed", required_argument, NULL, 256},
+		{"profile", required_argument, NULL, 257},
+		{"progress", required_argument, NULL, 258},
+		{"progress-interval", required_argument, NULL, 259},
+		{NULL, 0, NULL, 0}
+	};
 
 	data.word_size = 0;
 	initial_entropy = true;
 	all_bits = true;
 
-	while ((opt = getopt(argc, argv, "icatvl:")) != -1) {
+	while ((opt = getopt_long(argc, argv, "icatvl:w:s:fj:q:", long_options, NULL)) != -1) {
 		switch(opt) {
 			case 'i':
 				initial_entropy = true;
@@ -75,21 +156,45 @@ int main(int argc, char* argv[]){
 			case 'v':
 				verbose++;
 				break;
-                        case 'l':
-                                inint = strtoull(optarg, &nextOption, 0);
-                                if((inint > ULONG_MAX) || (errno == EINVAL) || (nextOption == NULL) || (*nextOption != ',')) {
-                                        print_usage();
-                                }
-                                subsetIndex = inint;
-
-                                nextOption++;
-
-                                inint = strtoull(nextOption, NULL, 0);
-                                if((inint > ULONG_MAX) || (errno == EINVAL)) {
-                                        print_usage();
-                                }
-                                subsetSize = inint;
-                                break;
+			case 'l':
+				if(!parse_slice_range(optarg, &range)) print_usage();
+				ranges.push_back(range);
+				break;
+			case 'w':
+				window_len = strtol(optarg, NULL, 0);
+				if(window_len <= 0) print_usage();
+				break;
+			case 's':
+				stride = strtol(optarg, NULL, 0);
+				if(stride <= 0) print_usage();
+				break;
+			case 'f':
+				follow = true;
+				break;
+			case 'j':
+				worker_count = atoi(optarg);
+				if(worker_count <= 0) print_usage();
+				break;
+			case 'q':
+				queue_depth = strtol(optarg, NULL, 0);
+				if(queue_depth <= 0) print_usage();
+				break;
+			case 256:
+				errno = 0;
+				key = strtoull(optarg, &end, 0);
+				if((errno != 0) || (end == optarg) || (*end != '\0')) print_usage();
+				seeded = true;
+				break;
+			case 257:
+				profile_path = optarg;
+				break;
+			case 258:
+				progress_destination = optarg;
+				break;
+			case 259:
+				progress_interval = strtol(optarg, &end, 0);
+				if((end == optarg) || (*end != '\0') || (progress_interval <= 0)) print_usage();
+				break;
 			default:
 				print_usage();
 		}
@@ -116,14 +221,70 @@ int main(int argc, char* argv[]){
 		}
 	}
 
+	settings.word_size = data.word_size;
+	settings.initial_entropy = initial_entropy;
+	settings.all_bits = all_bits;
+	settings.key = seeded ? &key : NULL;
+
+	if(!profile_init("ea_iid", file_path, profile_path)) exit(-1);
+
+	if((progress_destination != NULL) && !progress_configure(progress_destination, progress_interval)) {
+		printf("Can't report the progress to '%s'.\n", progress_destination);
+		exit(-1);
+	}
+
+	//The permutation tests report a failure if they can't be seeded, so an unreadable random source is
+	//reported as an error before any data is assessed
+	if(!seeded && !seed(probe)) {
+		printf("Can't seed the permutation tests.\n");
+		exit(-1);
+	}
+
+	if(verbose > 1) printf("Using the %s kernels\n", cpu_isa_name(cpu_isa()));
+
+	//A single subset is assessed as before; several are swept in one process
+	if((ranges.size() > 1) || ((ranges.size() == 1) && (ranges[0].last > ranges[0].first))) {
+		if(window_len > 0) {
+			printf("Streaming mode can't be combined with a subset sweep.\n");
+			print_usage();
+		}
+
+		if(slice_assessment(file_path, ranges, worker_count, iid_assess_window, &settings) < 0) {
+			printf("Error reading file.\n");
+			print_usage();
+		}
+		return 0;
+	}
+
+	if(ranges.size() == 1) {
+		subsetIndex = ranges[0].first;
+		subsetSize = ranges[0].subset_len;
+	}
+
+	if(window_len > 0) {
+		if(stride == 0) stride = window_len;
+		if(window_len < MIN_SIZE) printf("\n*** Warning: windows contain less than %d samples ***\n\n", MIN_SIZE);
+
+		if(stream_assessment(file_path, window_len, stride, follow, worker_count, queue_depth, iid_assess_window, &settings) < 0) {
+			printf("Error reading file.\n");
+			print_usage();
+		}
+		return 0;
+	}
+
 	if(verbose > 0){
 		printf("Opening file: '%s'\n", file_path);
 	}
 
-	if(!read_file_subset(file_path, &data, subsetIndex, subsetSize)){
+	{
+		ProfileScope profile("read_file", NULL, 0);
+		loaded = read_file_subset(file_path, &data, subsetIndex, subsetSize);
+	}
+	if(!loaded){
 		printf("Error reading file.\n");
 		print_usage();
 	}
+	profile_set_input(data.len, data.word_size);
 	if(verbose > 0) printf("Loaded %ld samples of %d distinct %d-bit-wide symbols\n", data.len, data.alph_size, data.word_size);
 
 	if(data.alph_size <= 1){
@@ -145,7 +306,10 @@ int main(int argc, char* argv[]){
 	int sample_size = data.len;
 
 	printf("Calculating baseline statistics...\n");
-	calc_stats(&data, rawmean, median);
+	{
+		ProfileScope profile("calc_stats", NULL, sample_size);
+		calc_stats(&data, rawmean, median);
+	}
 
 	if(verbose > 0){
 		printf("\tRaw Mean: %f\n", rawmean);
@@ -210,7 +374,7 @@ int main(int argc, char* argv[]){
 	}
 
 	// Compute permutation stats
-	bool perm_test_pass = permutation_tests(&data, rawmean, median, verbose);
+	bool perm_test_pass = permutation_tests(&data, rawmean, median, verbose, false, seeded ? &key : NULL);
 
 	if(perm_test_pass){
 		printf("** Passed IID permutation tests\n\n");
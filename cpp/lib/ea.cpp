@@ -0,0 +1,380 @@
+//The C interface of libea (see ea.h): a wrapper over the estimator and assessment objects that
+//libea.a is built from, which loads data into a context and returns the results as plain structs.
+#include "../shared/utils.h"
+#include "../non_iid/non_iid_assess.h"
+#include "../iid/iid_assess.h"
+#include "ea.h"
+
+//The shortest data that each estimator can be run on; they assert on anything shorter
+#define EA_LAG_MIN_LEN 3
+#define EA_MULTI_MMC_MIN_LEN 4
+#define EA_LZ78Y_MIN_LEN (LZ78Y_B + 3)
+
+struct ea_context {
+	data_t data;
+	bool loaded;
+	long capacity;		// the number of samples that data.symbols and data.rawsymbols can hold
+	long bit_capacity;	// the number of bits that bits can hold
+	byte *bits;		// the bitstring view, for multi-bit symbols
+	long histogram[2][256];	// indexed by ea_view
+	struct arena scratch;	// the estimators' scratch memory, sized when data is loaded
+	bool seeded;		// whether ea_iid draws its permutations from key, rather than /dev/urandom
+	uint64_t key;
+};
+
+const char *ea_status_string(int status) {
+	switch(status) {
+		case EA_OK: return "success";
+		case EA_ERROR_ARGUMENT: return "invalid argument";
+		case EA_ERROR_IO: return "could not read the samples";
+		case EA_ERROR_MEMORY: return "out of memory";
+		case EA_ERROR_WORD_SIZE: return "data does not fit within the described bit width";
+		case EA_ERROR_NO_DATA: return "no data loaded";
+		case EA_ERROR_ONE_SYMBOL: return "symbol alphabet consists of 1 symbol";
+		case EA_ERROR_TOO_SHORT: return "not enough samples for the estimator";
+		case EA_ERROR_RANDOM: return "could not seed the permutation tests";
+		default: return "unknown error";
+	}
+}
+
+ea_context *ea_context_new(void) {
+	ea_context *ctx = new(nothrow) ea_context();
+
+	if(ctx != NULL) arena_init(&ctx->scratch, 0);
+
+	return ctx;
+}
+
+void ea_context_free(ea_context *ctx) {
+	if(ctx == NULL) return;
+
+	free(ctx->data.symbols);
+	free(ctx->data.rawsymbols);
+	free(ctx->bits);
+	arena_free(&ctx->scratch);
+	delete ctx;
+}
+
+static void count_view(ea_context *ctx, enum ea_view view) {
+	const byte *symbols = (view == EA_LITERAL) ? ctx->data.symbols : ctx->data.bsymbols;
+	long len = (view == EA_LITERAL) ? ctx->data.len : ctx->data.blen;
+
+	memset(ctx->histogram[view], 0, sizeof(ctx->histogram[view]));
+	for(long i = 0; i < len; i++) ctx->histogram[view][symbols[i]]++;
+}
+
+int ea_load_buffer(ea_context *ctx, const unsigned char *samples, long len, int word_size) {
+	int width;
+
+	if((ctx == NULL) || (samples == NULL) || (len <= 0) || (word_size < 0) || (word_size > 8)) return EA_ERROR_ARGUMENT;
+
+	ctx->loaded = false;
+
+	width = symbol_bit_width(samples, len);
+	if(word_size == 0) word_size = max(width, 1);
+	else if(width > word_size) return EA_ERROR_WORD_SIZE;
+
+	//The buffers only ever grow, so that loading captures of similar sizes doesn't allocate
+	if(len > ctx->capacity) {
+		free(ctx->data.symbols);
+		free(ctx->data.rawsymbols);
+		ctx->data.symbols = (byte *)malloc(len);
+		ctx->data.rawsymbols = (byte *)malloc(len);
+		ctx->capacity = len;
+
+		if((ctx->data.symbols == NULL) || (ctx->data.rawsymbols == NULL)) {
+			free(ctx->data.symbols);
+			free(ctx->data.rawsymbols);
+			ctx->data.symbols = NULL;
+			ctx->data.rawsymbols = NULL;
+			ctx->capacity = 0;
+			return EA_ERROR_MEMORY;
+		}
+	}
+
+	if((word_size > 1) && (len * word_size > ctx->bit_capacity)) {
+		free(ctx->bits);
+		ctx->bits = (byte *)malloc(len * word_size);
+		ctx->bit_capacity = len * word_size;
+
+		if(ctx->bits == NULL) {
+			ctx->bit_capacity = 0;
+			return EA_ERROR_MEMORY;
+		}
+	}
+
+	memcpy(ctx->data.symbols, samples, len);
+	ctx->data.len = len;
+	ctx->data.word_size = word_size;
+
+	//The width was checked above, and the bitstring buffer is supplied, so this doesn't fail in practice
+	if(!process_symbols(&ctx->data, ctx->bits)) {
+		ctx->capacity = 0;
+		return EA_ERROR_WORD_SIZE;
+	}
+
+	count_view(ctx, EA_LITERAL);
+	count_view(ctx, EA_BITSTRING);
+	try {
+		arena_reserve(&ctx->scratch, non_iid_scratch_size(&ctx->data));
+	} catch(const bad_alloc &) {
+		return EA_ERROR_MEMORY;
+	}
+	ctx->loaded = true;
+
+	return EA_OK;
+}
+
+int ea_load_file(ea_context *ctx, const char *path, long subset_index, long subset_len, int word_size) {
+	const byte *buffer;
+	long file_len, offset, len;
+	int status;
+
+	if((ctx == NULL) || (path == NULL) || (subset_index < 0) || (subset_len < 0)) return EA_ERROR_ARGUMENT;
+
+	ctx->loaded = false;
+	if(!map_file(path, &buffer, &file_len)) return EA_ERROR_IO;
+
+	offset = subset_index * subset_len;
+	len = (subset_len == 0) ? file_len : min(subset_len, file_len - offset);
+
+	if(len <= 0) status = EA_ERROR_IO;
+	else status = ea_load_buffer(ctx, buffer + offset, len, word_size);
+
+	unmap_file(buffer, file_len);
+
+	return status;
+}
+
+int ea_limit_bitstring(ea_context *ctx, long max_bits) {
+	if(ctx == NULL || max_bits <= 0) return EA_ERROR_ARGUMENT;
+	if(!ctx->loaded) return EA_ERROR_NO_DATA;
+
+	if(ctx->data.blen > max_bits) {
+		ctx->data.blen = max_bits;
+		count_view(ctx, EA_BITSTRING);
+	}
+
+	return EA_OK;
+}
+
+int ea_set_seed(ea_context *ctx, unsigned long long seed) {
+	if(ctx == NULL) return EA_ERROR_ARGUMENT;
+
+	ctx->seeded = true;
+	ctx->key = seed;
+
+	return EA_OK;
+}
+
+int ea_dataset_info(const ea_context *ctx, struct ea_dataset *info) {
+	if((ctx == NULL) || (info == NULL)) return EA_ERROR_ARGUMENT;
+	if(!ctx->loaded) return EA_ERROR_NO_DATA;
+
+	info->len = ctx->data.len;
+	info->blen = ctx->data.blen;
+	info->word_size = ctx->data.word_size;
+	info->alph_size = ctx->data.alph_size;
+
+	return EA_OK;
+}
+
+int ea_histogram(const ea_context *ctx, enum ea_view view, long counts[256]) {
+	if((ctx == NULL) || (counts == NULL) || ((view != EA_LITERAL) && (view != EA_BITSTRING))) return EA_ERROR_ARGUMENT;
+	if(!ctx->loaded) return EA_ERROR_NO_DATA;
+
+	memcpy(counts, ctx->histogram[view], sizeof(ctx->histogram[view]));
+
+	return EA_OK;
+}
+
+//Selects the data for a view. binary_only is set for the estimators that only apply to binary data.
+static int view_data(ea_context *ctx, enum ea_view view, bool binary_only, byte **symbols, long *len, int *alph_size) {
+	if((ctx == NULL) || ((view != EA_LITERAL) && (view != EA_BITSTRING))) return EA_ERROR_ARGUMENT;
+	if(!ctx->loaded) return EA_ERROR_NO_DATA;
+	if(ctx->data.alph_size <= 1) return EA_ERROR_ONE_SYMBOL;
+
+	if(view == EA_LITERAL) {
+		if(binary_only && (ctx->data.alph_size != 2)) return EA_ERROR_ARGUMENT;
+		*symbols = ctx->data.symbols;
+		*len = ctx->data.len;
+		*alph_size = ctx->data.alph_size;
+	} else {
+		*symbols = ctx->data.bsymbols;
+		*len = ctx->data.blen;
+		*alph_size = 2;
+	}
+
+	return EA_OK;
+}
+
+//The estimators return a negative value when they can't be run on the data. An estimate of no entropy at all
+//(the bound on the most likely outcome is 1) comes back as -0.0, which is reported as 0.0.
+static int fill_estimate(const ea_context *ctx, enum ea_view view, long len, double min_entropy, struct ea_estimate *estimate) {
+	if(estimate != NULL) {
+		estimate->min_entropy = min_entropy + 0.0;
+		estimate->bits_per_symbol = (view == EA_LITERAL) ? ctx->data.word_size : 1;
+		estimate->samples = len;
+	}
+
+	return (min_entropy < 0.0) ? EA_ERROR_TOO_SHORT : EA_OK;
+}
+
+int ea_most_common(ea_context *ctx, enum ea_view view, struct ea_estimate *estimate) {
+	byte *symbols;
+	long len;
+	int alph_size, status;
+
+	if((status = view_data(ctx, view, false, &symbols, &len, &alph_size)) != EA_OK) return status;
+
+	return fill_estimate(ctx, view, len, most_common_from_counts(ctx->histogram[view], len, alph_size, 0, ""), estimate);
+}
+
+int ea_collision(ea_context *ctx, enum ea_view view, struct ea_estimate *estimate) {
+	byte *symbols;
+	long len;
+	int alph_size, status;
+
+	if((status = view_data(ctx, view, true, &symbols, &len, &alph_size)) != EA_OK) return status;
+
+	return fill_estimate(ctx, view, len, collision_test(symbols, len, 0, ""), estimate);
+}
+
+int ea_markov(ea_context *ctx, enum ea_view view, struct ea_estimate *estimate) {
+	byte *symbols;
+	long len;
+	int alph_size, status;
+
+	if((status = view_data(ctx, view, true, &symbols, &len, &alph_size)) != EA_OK) return status;
+
+	return fill_estimate(ctx, view, len, markov_test(symbols, len, 0, ""), estimate);
+}
+
+int ea_compression(ea_context *ctx, enum ea_view view, struct ea_estimate *estimate) {
+	byte *symbols;
+	long len;
+	int alph_size, status;
+
+	if((status = view_data(ctx, view, true, &symbols, &len, &alph_size)) != EA_OK) return status;
+
+	return fill_estimate(ctx, view, len, compression_test(symbols, len, 0, ""), estimate);
+}
+
+int ea_t_tuple_lrs(ea_context *ctx, enum ea_view view, struct ea_estimate *t_tuple, struct ea_estimate *lrs) {
+	byte *symbols;
+	long len;
+	int alph_size, status;
+	double t_tuple_res = -1.0, lrs_res = -1.0;
+
+	if((status = view_data(ctx, view, false, &symbols, &len, &alph_size)) != EA_OK) return status;
+	//The longest repeated substring is empty unless some symbol repeats
+	if(len <= alph_size) return EA_ERROR_TOO_SHORT;
+
+	SAalgs(symbols, len, alph_size, t_tuple_res, lrs_res, 0, "", &ctx->scratch);
+
+	status = fill_estimate(ctx, view, len, t_tuple_res, t_tuple);
+	if(fill_estimate(ctx, view, len, lrs_res, lrs) != EA_OK) status = EA_ERROR_TOO_SHORT;
+
+	return status;
+}
+
+int ea_multi_mcw(ea_context *ctx, enum ea_view view, struct ea_estimate *estimate) {
+	byte *symbols;
+	long len;
+	int alph_size, status;
+
+	if((status = view_data(ctx, view, false, &symbols, &len, &alph_size)) != EA_OK) return status;
+
+	return fill_estimate(ctx, view, len, multi_mcw_test(symbols, len, alph_size, 0, ""), estimate);
+}
+
+int ea_lag(ea_context *ctx, enum ea_view view, struct ea_estimate *estimate) {
+	byte *symbols;
+	long len;
+	int alph_size, status;
+
+	if((status = view_data(ctx, view, false, &symbols, &len, &alph_size)) != EA_OK) return status;
+	if(len < EA_LAG_MIN_LEN) return EA_ERROR_TOO_SHORT;
+
+	return fill_estimate(ctx, view, len, lag_test(symbols, len, alph_size, 0, ""), estimate);
+}
+
+int ea_multi_mmc(ea_context *ctx, enum ea_view view, struct ea_estimate *estimate) {
+	byte *symbols;
+	long len;
+	int alph_size, status;
+
+	if((status = view_data(ctx, view, false, &symbols, &len, &alph_size)) != EA_OK) return status;
+	if(len < EA_MULTI_MMC_MIN_LEN) return EA_ERROR_TOO_SHORT;
+
+	return fill_estimate(ctx, view, len, multi_mmc_test(symbols, len, alph_size, 0, "", &ctx->scratch), estimate);
+}
+
+int ea_lz78y(ea_context *ctx, enum ea_view view, struct ea_estimate *estimate) {
+	byte *symbols;
+	long len;
+	int alph_size, status;
+
+	if((status = view_data(ctx, view, false, &symbols, &len, &alph_size)) != EA_OK) return status;
+	if(len < EA_LZ78Y_MIN_LEN) return EA_ERROR_TOO_SHORT;
+
+	return fill_estimate(ctx, view, len, LZ78Y_test(symbols, len, alph_size, 0, "", &ctx->scratch), estimate);
+}
+
+//Whether the estimators that assert on short data can all be run on a view (LZ78Y needs the most)
+static bool view_runnable(long len, int alph_size) {
+	return (len >= EA_LZ78Y_MIN_LEN) && (len > alph_size);
+}
+
+int ea_non_iid(ea_context *ctx, int initial_entropy, struct ea_non_iid_result *result) {
+	struct non_iid_result assessment;
+	int status = EA_OK;
+
+	if((ctx == NULL) || (result == NULL)) return EA_ERROR_ARGUMENT;
+	if(!ctx->loaded) return EA_ERROR_NO_DATA;
+	if(ctx->data.alph_size <= 1) return EA_ERROR_ONE_SYMBOL;
+	if(initial_entropy && !view_runnable(ctx->data.len, ctx->data.alph_size)) return EA_ERROR_TOO_SHORT;
+	if(((ctx->data.alph_size > 2) || !initial_entropy) && !view_runnable(ctx->data.blen, 2)) return EA_ERROR_TOO_SHORT;
+
+	non_iid_assess(&ctx->data, initial_entropy != 0, 0, &assessment, &ctx->scratch);
+
+	result->H_original = assessment.H_original;
+	result->H_bitstring = assessment.H_bitstring;
+	result->h_assessed = assessment.h_assessed + 0.0;
+	result->estimate_count = min((int)assessment.estimates.size(), EA_MAX_ESTIMATES);
+	for(int i = 0; i < result->estimate_count; i++) {
+		result->estimates[i] = assessment.estimates[i] + 0.0;
+		//h_assessed is only an assessment if every estimator produced an estimate
+		if(result->estimates[i] < 0.0) status = EA_ERROR_TOO_SHORT;
+	}
+
+	return status;
+}
+
+int ea_iid(ea_context *ctx, int initial_entropy, struct ea_iid_result *result) {
+	struct iid_result assessment;
+	uint64_t probe[4];
+
+	if((ctx == NULL) || (result == NULL)) return EA_ERROR_ARGUMENT;
+	if(!ctx->loaded) return EA_ERROR_NO_DATA;
+	if(ctx->data.alph_size <= 1) return EA_ERROR_ONE_SYMBOL;
+	//The permutation tests compare samples up to lags[NUM_LAGS-1] apart, packing binary data 8 bits to a byte,
+	//and the LRS test needs a repeated symbol
+	if(ctx->data.len < ((ctx->data.alph_size == 2) ? 8 : 1) * (long)lags[NUM_LAGS-1]) return EA_ERROR_TOO_SHORT;
+	if(ctx->data.len <= ctx->data.alph_size) return EA_ERROR_TOO_SHORT;
+
+	//The permutation tests report a failure if they can't be seeded, so check for that separately
+	if(!ctx->seeded && !seed(probe)) return EA_ERROR_RANDOM;
+
+	iid_assess(&ctx->data, initial_entropy != 0, &assessment, &ctx->scratch, ctx->seeded ? &ctx->key : NULL);
+
+	result->H_original = assessment.H_original;
+	result->H_bitstring = assessment.H_bitstring;
+	result->h_assessed = assessment.h_assessed;
+	result->chi_square_pass = assessment.chi_square_test_pass;
+	result->lrs_pass = assessment.len_LRS_test_pass;
+	result->permutation_pass = assessment.perm_test_pass;
+	result->iid = assessment.chi_square_test_pass && assessment.len_LRS_test_pass && assessment.perm_test_pass;
+
+	return EA_OK;
+}
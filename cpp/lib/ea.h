@@ -0,0 +1,111 @@
+#pragma once
+
+//The public interface of libea, which runs the SP 800-90B assessments within a calling process.
+//
+//An ea_context holds a loaded dataset along with its derived views (the translated symbols, the
+//bitstring and their histograms), and keeps its buffers between loads, so a long running program
+//can assess many captures without reallocating. A context may be used by one thread at a time;
+//separate contexts may be used concurrently.
+//
+//Every call returns EA_OK or one of the error codes below; nothing in the library exits the process.
+//Link with: -lea -lbz2 -lpthread -ldivsufsort -fopenmp
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//The largest number of estimates produced by ea_non_iid (ten for each of the two views)
+#define EA_MAX_ESTIMATES 20
+
+enum ea_status {
+	EA_OK = 0,
+	EA_ERROR_ARGUMENT,	// an argument was out of range, or the estimator doesn't apply to the view
+	EA_ERROR_IO,		// the file couldn't be opened or read, or the subset is past its end
+	EA_ERROR_MEMORY,
+	EA_ERROR_WORD_SIZE,	// the data doesn't fit within the given bits per symbol
+	EA_ERROR_NO_DATA,	// nothing has been loaded into the context
+	EA_ERROR_ONE_SYMBOL,	// every sample is the same symbol, so no entropy can be awarded
+	EA_ERROR_TOO_SHORT,	// there aren't enough samples for the estimator
+	EA_ERROR_RANDOM		// the permutation tests couldn't be seeded
+};
+
+//Which form of the data an estimator is run on
+enum ea_view {
+	EA_LITERAL = 0,		// the symbols, translated down to 0 ... alph_size-1
+	EA_BITSTRING = 1	// the symbols expanded to bits, most significant bit first
+};
+
+typedef struct ea_context ea_context;
+
+struct ea_dataset {
+	long len;		// the number of samples
+	long blen;		// the number of bits in the bitstring view
+	int word_size;		// bits per symbol
+	int alph_size;		// the number of distinct symbols
+};
+
+struct ea_estimate {
+	double min_entropy;	// per symbol of the view (so at most 1 for the bitstring)
+	int bits_per_symbol;	// word_size for the literal view, 1 for the bitstring
+	long samples;		// the number of symbols of the view that were assessed
+};
+
+struct ea_non_iid_result {
+	double H_original;
+	double H_bitstring;
+	double h_assessed;
+	int estimate_count;
+	//Every estimate, in the order that ea_non_iid runs them (negative if the estimator didn't apply)
+	double estimates[EA_MAX_ESTIMATES];
+};
+
+struct ea_iid_result {
+	double H_original;
+	double H_bitstring;
+	double h_assessed;
+	int chi_square_pass;
+	int lrs_pass;
+	int permutation_pass;
+	int iid;		// all three tests passed
+};
+
+const char *ea_status_string(int status);
+
+ea_context *ea_context_new(void);
+void ea_context_free(ea_context *ctx);
+
+//Loads len samples, each holding a symbol in its low word_size bits (0 to infer the width from the data)
+int ea_load_buffer(ea_context *ctx, const unsigned char *samples, long len, int word_size);
+//Loads the subset_index'th run of subset_len samples of a file, or the whole file if subset_len is 0
+int ea_load_file(ea_context *ctx, const char *path, long subset_index, long subset_len, int word_size);
+//Limits the bitstring view to its first max_bits bits, as the tools' -t option does, until the next load
+int ea_limit_bitstring(ea_context *ctx, long max_bits);
+
+//Makes ea_iid draw its permutations from seed rather than from /dev/urandom, so that its results can be
+//reproduced. The seed is kept across loads.
+int ea_set_seed(ea_context *ctx, unsigned long long seed);
+
+int ea_dataset_info(const ea_context *ctx, struct ea_dataset *info);
+//The number of times each symbol occurs in the view
+int ea_histogram(const ea_context *ctx, enum ea_view view, long counts[256]);
+
+//The estimators of SP 800-90B Section 6.3. The collision, Markov and compression estimates only apply
+//to binary data, so for the literal view they require a two symbol alphabet.
+int ea_most_common(ea_context *ctx, enum ea_view view, struct ea_estimate *estimate);
+int ea_collision(ea_context *ctx, enum ea_view view, struct ea_estimate *estimate);
+int ea_markov(ea_context *ctx, enum ea_view view, struct ea_estimate *estimate);
+int ea_compression(ea_context *ctx, enum ea_view view, struct ea_estimate *estimate);
+int ea_t_tuple_lrs(ea_context *ctx, enum ea_view view, struct ea_estimate *t_tuple, struct ea_estimate *lrs);
+int ea_multi_mcw(ea_context *ctx, enum ea_view view, struct ea_estimate *estimate);
+int ea_lag(ea_context *ctx, enum ea_view view, struct ea_estimate *estimate);
+int ea_multi_mmc(ea_context *ctx, enum ea_view view, struct ea_estimate *estimate);
+int ea_lz78y(ea_context *ctx, enum ea_view view, struct ea_estimate *estimate);
+
+//The full assessments made by ea_non_iid and ea_iid (-i for an initial entropy estimate, otherwise -c).
+//ea_non_iid returns EA_ERROR_TOO_SHORT, with the estimates that could be made, if any estimator needed more data.
+int ea_non_iid(ea_context *ctx, int initial_entropy, struct ea_non_iid_result *result);
+int ea_iid(ea_context *ctx, int initial_entropy, struct ea_iid_result *result);
+
+#ifdef __cplusplus
+}
+#endif
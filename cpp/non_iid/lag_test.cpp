@@ -0,0 +1,85 @@
+#include "lag_test.h"
+#include "../shared/profile.h"
+
+double lag_test(byte *S, long L, int k, const int verbose, const char *label) {
+	ProfileScope profile("lag_test", label, L);
+	long scoreboard[D_LAG] = {0};
+	int winner = 0;
+	long curRunOfCorrects = 0;
+	long maxRunOfCorrects = 0;
+	long correctCount = 0;
+	lagBuf *ringBuffers;
+	long highScore = 0;
+
+	assert(S != NULL);
+	assert(L > 2);
+	assert(k >= 2);
+
+	ringBuffers = new lagBuf[k];
+
+	//Flag all the rings as empty
+	for (int j = 0; j < k; j++) {
+		ringBuffers[j].start = 0;
+		ringBuffers[j].end = 0;
+	}
+
+	// Account for the very first symbol (there isn't a guess for this one)
+	ringBuffers[S[0]].buf[0] = 0;
+	ringBuffers[S[0]].start = 0;
+	ringBuffers[S[0]].end = 1;
+
+	// The rest of the values yield a prediction
+	for (long i = 1; i < L; i++) {
+		const byte curSymbol = S[i];
+		lagBuf *const curRingBuffer = &(ringBuffers[curSymbol]); // The pointer itself is a constant (not the structure it points to)
+
+		// Check the prediction first
+		if (curSymbol == S[i - winner - 1]) {
+			correctCount++;
+			curRunOfCorrects++;
+			if (curRunOfCorrects > maxRunOfCorrects) {
+				maxRunOfCorrects = curRunOfCorrects;
+			}
+		} else {
+			curRunOfCorrects = 0;
+		}
+
+		// Update counters
+		if (curRingBuffer->start != curRingBuffer->end) {
+			uint8_t counterIndex = curRingBuffer->end;
+			const long cutoff = (i >= D_LAG) ? (i - D_LAG) : 0;  // Cutoff is the oldest stream index that should be present in the buffer
+
+			do {
+				counterIndex--;
+				if (curRingBuffer->buf[counterIndex&LAGMASK] >= cutoff) {
+					long curScore;
+					long curOffset;
+					curOffset = i - curRingBuffer->buf[counterIndex&LAGMASK] - 1;
+					assert(curOffset < D_LAG);
+					curScore = ++scoreboard[curOffset];
+
+					if (curScore >= highScore) {
+						winner = curOffset;
+						highScore = curScore;
+					}
+				} else {
+					// The correct start was the prior symbol (which is the next symbol in the buffer)
+					curRingBuffer->start = (uint8_t)(counterIndex + 1U);
+					break;
+				}
+			} while (counterIndex != curRingBuffer->start);
+		}
+
+		// Add the new symbol
+		// Are we already full? If so, advance the start index.
+		if((uint8_t)(curRingBuffer->end - curRingBuffer->start) == D_LAG) curRingBuffer->start++;
+		//Add the current offset and adjust the end index
+		curRingBuffer->buf[(curRingBuffer->end)&LAGMASK] = i;
+		curRingBuffer->end++;
+		assert((uint8_t)(curRingBuffer->end - curRingBuffer->start) <= D_LAG);
+	}
+
+	delete[] ringBuffers;
+
+	return predictionEstimate(correctCount, L-1, maxRunOfCorrects, k, "Lag", verbose, label);
+}
@@ -0,0 +1,167 @@
+#include "markov_test.h"
+#include "../shared/profile.h"
+
+double markov_from_counts(long C_0, const long C_00, const long C_10, const byte last, const long len, const int verbose, const char *label){
+	long C_1;
+	double H_min, tmp_min_entropy, P_0, P_1, P_00, P_01, P_10, P_11, entEst;
+
+	//Less than 2 symbols don't make sense for a Markov model.
+	assert(len > 1);
+
+	C_1 = len - 1 - C_0; //C_1 is the number of 1 bits from S[0] to S[len-2]
+
+	//Note that P_X1 = C_X1 / C_X = (C_X - C_X0)/C_X = 1.0 - C_X0/C_X = 1.0 - P_X0 
+	if(C_0 > 0) {
+		P_00 = ((double)C_00) / ((double)C_0);
+		P_01 = 1.0 - P_00;
+	} else {
+		P_00 = 0.0;
+		P_01 = 0.0;
+	}
+
+	if(C_1 > 0) {
+		P_10 = ((double)C_10) / ((double)C_1);
+		P_11 = 1.0 - P_10;
+	} else {
+		P_10 = 0.0;
+		P_11 = 0.0;
+	}
+
+	// account for the last symbol
+	if(last == 0) C_0++;
+	//C_0 is now  the number of 0 bits from S[0] to S[len-1]
+
+	P_0 = C_0 / (double)len;
+	P_1 = 1.0 - P_0;
+
+	if(verbose == 1) verbose_printf("%s Markov Estimate: P_0 = %.17g, P_1 = %.17g, P_0,0 = %.17g, P_0,1 = %.17g, P_1,0 = %.17g, P_1,1 = %.17g, ", label, P_0, P_1, P_00, P_01, P_10, P_11);
+	else if(verbose == 2) {
+		verbose_printf("%s Markov Estimate: P_0 = %.17g\n", label, P_0);
+		verbose_printf("%s Markov Estimate: P_1 = %.17g\n", label, P_1);
+		verbose_printf("%s Markov Estimate: P_{0,0} = %.17g\n", label, P_00);
+		verbose_printf("%s Markov Estimate: P_{0,1} = %.17g\n", label, P_01);
+		verbose_printf("%s Markov Estimate: P_{1,0} = %.17g\n", label, P_10);
+		verbose_printf("%s Markov Estimate: P_{1,1} = %.17g\n", label, P_11);
+	}
+
+	H_min = 128.0;
+
+	//In the next block, note that if P_0X > 0.0, then P_0 > 0.0
+	//and similarly if P_1X > 0.0, then P_1 > 0.0
+	
+	// Sequence 00...0
+	if(P_00 > 0.0){
+		tmp_min_entropy = -log2(P_0) - 127.0*log2(P_00); 
+		if(tmp_min_entropy < H_min) H_min = tmp_min_entropy;
+	}
+
+	// Sequence 0101...01
+	if((P_01 > 0.0) && (P_10 > 0.0)){
+		tmp_min_entropy = -log2(P_0) - 64.0*log2(P_01) - 63.0*log2(P_10);
+		if(tmp_min_entropy < H_min) H_min = tmp_min_entropy;
+	}
+
+        // Sequence 011...1
+	if((P_01 > 0.0) && (P_11 > 0.0)){
+        	tmp_min_entropy = -log2(P_0) - log2(P_01) - 126.0*log2(P_11);
+       		if(tmp_min_entropy < H_min) H_min = tmp_min_entropy;	
+	}
+
+        // Sequence 100...0
+	if((P_10 > 0.0) && (P_00 > 0.0)){
+        	tmp_min_entropy = -log2(P_1) - log2(P_10) - 126.0*log2(P_00);
+       		if(tmp_min_entropy < H_min) H_min = tmp_min_entropy;
+	}
+
+        // Sequence 1010...10
+	if((P_10 > 0.0) && (P_01 > 0.0)){
+       		tmp_min_entropy = -log2(P_1) - 64.0*log2(P_10) - 63.0*log2(P_01);
+        	if(tmp_min_entropy < H_min) H_min = tmp_min_entropy;
+	}
+
+        // Sequence 11...1
+	if(P_11 > 0.0){
+        	tmp_min_entropy = -log2(P_1) - 127.0*log2(P_11);
+       		if(tmp_min_entropy < H_min) H_min = tmp_min_entropy;
+	}
+
+	entEst = fmin(H_min/128.0, 1.0);
+
+	if(verbose == 1) verbose_printf("p_max = %.17g\n", pow(2.0, -H_min));
+	else if(verbose == 2) {
+		verbose_printf("%s Markov Estimate: p-hat_max = %.17g\n", label, pow(2.0, -H_min));
+		verbose_printf("%s Markov Estimate: min entropy = %.17g\n", label, entEst);
+	}
+
+	return entEst;
+}
+
+double markov_test(byte* data, long len, const int verbose, const char *label){
+	ProfileScope profile("markov_test", label, len);
+	long i, C_0, C_00, C_10;
+
+	C_0 = 0;
+	C_00 = 0;
+	C_10 = 0;
+
+	//Less than 2 symbols don't make sense for a Markov model.
+	assert(len > 1);
+
+	// get counts for unconditional and transition probabilities
+	for(i = 0; i < len-1; i++){
+		if(data[i] == 0){
+			C_0++;
+			if(data[i+1] == 0) C_00++;
+		}
+		else if(data[i+1] == 0) C_10++;
+	}
+
+	//C_0 is now  the number of 0 bits from S[0] to S[len-2]
+
+	return markov_from_counts(C_0, C_00, C_10, data[len-1], len, verbose, label);
+}
+
+void markov_counts_init(struct markov_counts *c, const byte *data, const long len){
+	assert(len > 1);
+
+	c->C_0 = 0;
+	c->C_00 = 0;
+	c->C_10 = 0;
+	c->len = len;
+
+	for(long i = 0; i < len-1; i++){
+		if(data[i] == 0){
+			c->C_0++;
+			if(data[i+1] == 0) c->C_00++;
+		}
+		else if(data[i+1] == 0) c->C_10++;
+	}
+
+	c->last = data[len-1];
+}
+
+void markov_counts_slide(struct markov_counts *c, const byte *window, const long stride){
+	assert(stride <= c->len);
+
+	for(long i = 0; i < stride; i++){
+		// drop the transition out of the first bit of the window
+		if(window[i] == 0){
+			c->C_0--;
+			if(window[i+1] == 0) c->C_00--;
+		}
+		else if(window[i+1] == 0) c->C_10--;
+
+		// add the transition into the new last bit
+		if(window[c->len-1+i] == 0){
+			c->C_0++;
+			if(window[c->len+i] == 0) c->C_00++;
+		}
+		else if(window[c->len+i] == 0) c->C_10++;
+	}
+
+	c->last = window[c->len-1+stride];
+}
+
+double markov_incremental(const struct markov_counts *c, const int verbose, const char *label){
+	return markov_from_counts(c->C_0, c->C_00, c->C_10, c->last, c->len, verbose, label);
+}
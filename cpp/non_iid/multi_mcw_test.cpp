@@ -0,0 +1,124 @@
+#include "multi_mcw_test.h"
+#include "../shared/profile.h"
+
+void mcw_init(struct mcw_state *st, const byte *data, int alph_size){
+	const int *W = MCW_WINDOWS;
+	long i, j;
+
+	assert(alph_size <= 256);
+
+	st->alph_size = alph_size;
+	st->winner = 0;
+	st->C = 0;
+	st->run_len = 0;
+	st->max_run_len = 0;
+	for(i = 0; i < NUM_WINS; i++){
+		st->scoreboard[i] = 0;
+		st->max_cnts[i] = 0;
+		for(j = 0; j < alph_size; j++){
+			st->win_cnts[i][j] = 0;
+			st->win_poses[i][j] = 0;
+		}
+	}
+
+	// compute initial window counts
+	for(i = 0; i < W[NUM_WINS-1]; i++){
+		for(j = 0; j < NUM_WINS; j++){
+			if(i < W[j]){
+				if(st->max_cnts[j] <= ++st->win_cnts[j][data[i]]){
+					st->max_cnts[j] = st->win_cnts[j][data[i]];
+					st->frequent[j] = data[i];
+				}
+				st->win_poses[j][data[i]] = i;
+			}
+		}
+	}
+
+	st->pos = W[0];
+}
+
+void mcw_advance(struct mcw_state *st, const byte *data, long first, long len){
+	const int *W = MCW_WINDOWS;
+	int winner = st->winner;
+	long i, j, k, max_pos;
+	long C = st->C, run_len = st->run_len, max_run_len = st->max_run_len;
+	long *scoreboard = st->scoreboard;
+	long *max_cnts = st->max_cnts;
+	byte *frequent = st->frequent;
+	int alph_size = st->alph_size;
+
+	assert(first <= max(st->pos - W[NUM_WINS-1], 0L));
+
+	// perform predictions
+	for (i = st->pos; i < len; i++){
+		byte cur = data[i-first];
+
+		// test prediction of winner
+		if(frequent[winner] == cur){
+			C++;
+			if(++run_len > max_run_len) max_run_len = run_len;
+		}
+		else run_len = 0;
+
+		// update scoreboard and select new winner
+		for(j = 0; j < NUM_WINS; j++){
+			if((i >= W[j]) && (frequent[j] == cur)){
+				if(++scoreboard[j] >= scoreboard[winner]) winner = j;
+			}
+		}
+	
+		// update window counts and select new frequents
+		for(j = 0; j < NUM_WINS; j++){
+			if(i >= W[j]){
+				long *win_cnts = st->win_cnts[j];
+				long *win_poses = st->win_poses[j];
+				byte old = data[i-W[j]-first];
+
+				win_cnts[old]--;
+				win_cnts[cur]++;
+				win_poses[cur] = i;
+				if((old != frequent[j]) && (max_cnts[j] <= win_cnts[cur])){
+					max_cnts[j] = win_cnts[cur];
+					frequent[j] = cur;
+				}
+				else if(old == frequent[j]){
+					max_cnts[j]--;
+					// search for possible new frequent
+					max_pos = i-W[j];
+					for(k = 0; k < alph_size; k++){
+						if((max_cnts[j] < win_cnts[k]) || ((max_cnts[j] == win_cnts[k]) && (max_pos <= win_poses[k]))){
+							max_cnts[j] = win_cnts[k];
+							frequent[j] = k;
+							max_pos = win_poses[k];
+						}
+					}
+				}
+			}
+		}
+	}
+
+	st->pos = max(st->pos, len);
+	st->winner = winner;
+	st->C = C;
+	st->run_len = run_len;
+	st->max_run_len = max_run_len;
+}
+
+double mcw_estimate(const struct mcw_state *st, const int verbose, const char *label){
+	return(predictionEstimate(st->C, st->pos - MCW_WINDOWS[0], st->max_run_len, st->alph_size, "MultiMCW", verbose, label));
+}
+
+double multi_mcw_test(byte *data, long len, int alph_size, const int verbose, const char *label){
+	ProfileScope profile("multi_mcw_test", label, len);
+	struct mcw_state st;
+
+	if(len < MCW_WINDOWS[NUM_WINS-1]+1){	
+		if(verbose > 0) verbose_printf("\t*** Warning: not enough samples to run multiMCW test (need more than %d) ***\n", MCW_WINDOWS[NUM_WINS-1]+1);
+		return -1.0;
+	}
+
+	mcw_init(&st, data, alph_size);
+	mcw_advance(&st, data, 0, len);
+
+	return mcw_estimate(&st, verbose, label);
+}
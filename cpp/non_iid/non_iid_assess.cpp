@@ -0,0 +1,253 @@
+#include "non_iid_assess.h"
+
+size_t non_iid_scratch_size(const data_t *data) {
+	return max(sa_scratch_size(max(data->len, data->blen)), binary_dict_scratch_size(max(D_MMC, LZ78Y_B)));
+}
+
+void non_iid_assess(data_t *data, bool initial_entropy, int verbose, struct non_iid_result *result, struct arena *scratch) {
+	ScratchScope scope(scratch, non_iid_scratch_size(data));
+	double ret_min_entropy;
+	double bin_t_tuple_res = -1.0, bin_lrs_res = -1.0;
+	double t_tuple_res = -1.0, lrs_res = -1.0;
+
+	result->estimates.clear();
+
+	// The maximum min-entropy is -log2(1/2^word_size) = word_size
+	// The maximum bit string min-entropy is 1.0
+	result->H_original = data->word_size;
+	result->H_bitstring = 1.0;
+
+	if (verbose > 0) {
+		printf("\nRunning non-IID tests...\n\n");
+		printf("Running Most Common Value Estimate...\n");
+	}
+
+	// Section 6.3.1 - Estimate entropy with Most Common Value
+	if (((data->alph_size > 2) || !initial_entropy)) {
+		ret_min_entropy = most_common(data->bsymbols, data->blen, 2, verbose, "Bitstring");
+
+		if (verbose > 0) printf("\tMost Common Value Estimate (bit string) = %f / 1 bit(s)\n", ret_min_entropy);
+		result->H_bitstring = min(ret_min_entropy, result->H_bitstring);
+
+		result->estimates.push_back(ret_min_entropy);
+	}
+
+	if (initial_entropy) {
+		ret_min_entropy = most_common(data->symbols, data->len, data->alph_size, verbose, "Literal");
+		if (verbose > 0)
+			printf("\tMost Common Value Estimate = %f / %d bit(s)\n", ret_min_entropy, data->word_size);
+		result->H_original = min(ret_min_entropy, result->H_original);
+
+		result->estimates.push_back(ret_min_entropy);
+	}
+
+	if (verbose > 0) printf("\nRunning Entropic Statistic Estimates (bit strings only)...\n");
+
+	// Section 6.3.2 - Estimate entropy with Collision Test (for bit strings only)
+	if (((data->alph_size > 2) || !initial_entropy)) {
+		ret_min_entropy = collision_test(data->bsymbols, data->blen, verbose, "Bitstring");
+
+		if (verbose > 0) printf("\tCollision Test Estimate (bit string) = %f / 1 bit(s)\n", ret_min_entropy);
+		result->H_bitstring = min(ret_min_entropy, result->H_bitstring);
+
+		result->estimates.push_back(ret_min_entropy);
+	}
+
+	if (initial_entropy && (data->alph_size == 2)) {
+		ret_min_entropy = collision_test(data->symbols, data->len, verbose, "Literal");
+
+		if (verbose > 0) printf("\tCollision Test Estimate = %f / 1 bit(s)\n", ret_min_entropy);
+		result->H_original = min(ret_min_entropy, result->H_original);
+
+		result->estimates.push_back(ret_min_entropy);
+	}
+
+	// Section 6.3.3 - Estimate entropy with Markov Test (for bit strings only)
+	if (((data->alph_size > 2) || !initial_entropy)) {
+		ret_min_entropy = markov_test(data->bsymbols, data->blen, verbose, "Bitstring");
+
+		if (verbose > 0) printf("\tMarkov Test Estimate (bit string) = %f / 1 bit(s)\n", ret_min_entropy);
+		result->H_bitstring = min(ret_min_entropy, result->H_bitstring);
+
+		result->estimates.push_back(ret_min_entropy);
+	}
+
+	if (initial_entropy && (data->alph_size == 2)) {
+		ret_min_entropy = markov_test(data->symbols, data->len, verbose, "Literal");
+
+		if (verbose > 0) printf("\tMarkov Test Estimate = %f / 1 bit(s)\n", ret_min_entropy);
+		result->H_original = min(ret_min_entropy, result->H_original);
+
+		result->estimates.push_back(ret_min_entropy);
+	}
+
+	// Section 6.3.4 - Estimate entropy with Compression Test (for bit strings only)
+	if (((data->alph_size > 2) || !initial_entropy)) {
+		ret_min_entropy = compression_test(data->bsymbols, data->blen, verbose, "Bitstring");
+
+		if (ret_min_entropy >= 0) {
+			if (verbose > 0) printf("\tCompression Test Estimate (bit string) = %f / 1 bit(s)\n", ret_min_entropy);
+			result->H_bitstring = min(ret_min_entropy, result->H_bitstring);
+		}
+
+		result->estimates.push_back(ret_min_entropy);
+	}
+
+	if (initial_entropy && (data->alph_size == 2)) {
+		ret_min_entropy = compression_test(data->symbols, data->len, verbose, "Literal");
+
+		if (verbose > 0) printf("\ttCompression Test Estimate = %f / 1 bit(s)\n", ret_min_entropy);
+		result->H_original = min(ret_min_entropy, result->H_original);
+
+		result->estimates.push_back(ret_min_entropy);
+	}
+
+	if (verbose > 0) printf("\nRunning Tuple Estimates...\n");
+
+	// Section 6.3.5 - Estimate entropy with t-Tuple Test
+
+	if (((data->alph_size > 2) || !initial_entropy)) {
+		SAalgs(data->bsymbols, data->blen, 2, bin_t_tuple_res, bin_lrs_res, verbose, "Bitstring", scope.get());
+		if (bin_t_tuple_res >= 0.0) {
+			if (verbose > 0) printf("\tT-Tuple Test Estimate (bit string) = %f / 1 bit(s)\n", bin_t_tuple_res);
+			result->H_bitstring = min(bin_t_tuple_res, result->H_bitstring);
+		}
+
+		result->estimates.push_back(bin_t_tuple_res);
+
+	}
+
+	if (initial_entropy) {
+		SAalgs(data->symbols, data->len, data->alph_size, t_tuple_res, lrs_res, verbose, "Literal", scope.get());
+		if (t_tuple_res >= 0.0) {
+			if (verbose > 0) printf("\tT-Tuple Test Estimate = %f / %d bit(s)\n", t_tuple_res, data->word_size);
+			result->H_original = min(t_tuple_res, result->H_original);
+		}
+
+		result->estimates.push_back(t_tuple_res);
+	}
+
+	// Section 6.3.6 - Estimate entropy with LRS Test
+	if (((data->alph_size > 2) || !initial_entropy)) {
+		if (verbose > 0) printf("\tLRS Test Estimate (bit string) = %f / 1 bit(s)\n", bin_lrs_res);
+		result->H_bitstring = min(bin_lrs_res, result->H_bitstring);
+
+		result->estimates.push_back(bin_lrs_res);
+	}
+
+	if (initial_entropy) {
+		if (verbose > 0) printf("\tLRS Test Estimate = %f / %d bit(s)\n", lrs_res, data->word_size);
+		result->H_original = min(lrs_res, result->H_original);
+
+		result->estimates.push_back(lrs_res);
+	}
+
+	if (verbose > 0) printf("\nRunning Predictor Estimates...\n");
+
+	if (((data->alph_size > 2) || !initial_entropy)) {
+		// Section 6.3.7 - Estimate entropy with Multi Most Common in Window Test
+		ret_min_entropy = multi_mcw_test(data->bsymbols, data->blen, 2, verbose, "Bitstring");
+
+		if (ret_min_entropy >= 0) {
+			if (verbose > 0)
+				printf("\tMulti Most Common in Window (MultiMCW) Prediction Test Estimate (bit string) = %f / 1 bit(s)\n", ret_min_entropy);
+			result->H_bitstring = min(ret_min_entropy, result->H_bitstring);
+		}
+
+		result->estimates.push_back(ret_min_entropy);
+	}
+
+	if (initial_entropy) {
+		ret_min_entropy = multi_mcw_test(data->symbols, data->len, data->alph_size, verbose, "Literal");
+
+		if (ret_min_entropy >= 0) {
+			if (verbose > 0)
+				printf("\tMulti Most Common in Window (MultiMCW) Prediction Test Estimate = %f / %d bit(s)\n",
+					   ret_min_entropy, data->word_size);
+			result->H_original = min(ret_min_entropy, result->H_original);
+		}
+
+		result->estimates.push_back(ret_min_entropy);
+	}
+
+	// Section 6.3.8 - Estimate entropy with Lag Prediction Test
+	if (((data->alph_size > 2) || !initial_entropy)) {
+		ret_min_entropy = lag_test(data->bsymbols, data->blen, 2, verbose, "Bitstring");
+
+		if (ret_min_entropy >= 0) {
+			if (verbose > 0)
+				printf("\tLag Prediction Test Estimate (bit string) = %f / 1 bit(s)\n", ret_min_entropy);
+			result->H_bitstring = min(ret_min_entropy, result->H_bitstring);
+		}
+
+		result->estimates.push_back(ret_min_entropy);
+	}
+
+	if (initial_entropy) {
+		ret_min_entropy = lag_test(data->symbols, data->len, data->alph_size, verbose, "Literal");
+
+		if (ret_min_entropy >= 0) {
+			if (verbose > 0)
+				printf("\tLag Prediction Test Estimate = %f / %d bit(s)\n", ret_min_entropy, data->word_size);
+			result->H_original = min(ret_min_entropy, result->H_original);
+		}
+
+		result->estimates.push_back(ret_min_entropy);
+	}
+
+	// Section 6.3.9 - Estimate entropy with Multi Markov Model with Counting Test (MultiMMC)
+	if (((data->alph_size > 2) || !initial_entropy)) {
+		ret_min_entropy = multi_mmc_test(data->bsymbols, data->blen, 2, verbose, "Bitstring", scope.get());
+
+		if (ret_min_entropy >= 0) {
+			if (verbose > 0)
+				printf("\tMulti Markov Model with Counting (MultiMMC) Prediction Test Estimate (bit string) = %f / 1 bit(s)\n",
+					   ret_min_entropy);
+			result->H_bitstring = min(ret_min_entropy, result->H_bitstring);
+		}
+
+		result->estimates.push_back(ret_min_entropy);
+	}
+
+	if (initial_entropy) {
+		ret_min_entropy = multi_mmc_test(data->symbols, data->len, data->alph_size, verbose, "Literal", scope.get());
+
+		if (ret_min_entropy >= 0) {
+			if (verbose > 0)
+				printf("\tMulti Markov Model with Counting (MultiMMC) Prediction Test Estimate = %f / %d bit(s)\n",
+					   ret_min_entropy, data->word_size);
+			result->H_original = min(ret_min_entropy, result->H_original);
+		}
+
+		result->estimates.push_back(ret_min_entropy);
+	}
+
+	// Section 6.3.10 - Estimate entropy with LZ78Y Test
+	if (((data->alph_size > 2) || !initial_entropy)) {
+		ret_min_entropy = LZ78Y_test(data->bsymbols, data->blen, 2, verbose, "Bitstring", scope.get());
+
+		if (ret_min_entropy >= 0) {
+			if (verbose > 0)
+				printf("\tLZ78Y Prediction Test Estimate (bit string) = %f / 1 bit(s)\n", ret_min_entropy);
+			result->H_bitstring = min(ret_min_entropy, result->H_bitstring);
+		}
+
+		result->estimates.push_back(ret_min_entropy);
+	}
+
+	if (initial_entropy) {
+		ret_min_entropy = LZ78Y_test(data->symbols, data->len, data->alph_size, verbose, "Literal", scope.get());
+
+		if (ret_min_entropy >= 0) {
+			if (verbose > 0)
+				printf("\tLZ78Y Prediction Test Estimate = %f / %d bit(s)\n", ret_min_entropy, data->word_size);
+			result->H_original = min(ret_min_entropy, result->H_original);
+		}
+
+		result->estimates.push_back(ret_min_entropy);
+	}
+
+	result->h_assessed = data->word_size;
+	if ((data->alph_size > 2) || !initial_entropy) result->h_assessed = min(result->h_assessed, result->H_bitstring * data->word_size);
+	if (initial_entropy) result->h_assessed = min(result->h_assessed, result->H_original);
+}
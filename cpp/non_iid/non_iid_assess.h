@@ -0,0 +1,28 @@
+#pragma once
+#include "../shared/utils.h"
+#include "../shared/most_common.h"
+#include "../shared/lrs_test.h"
+#include "collision_test.h"
+#include "lz78y_test.h"
+#include "multi_mmc_test.h"
+#include "lag_test.h"
+#include "multi_mcw_test.h"
+#include "compression_test.h"
+#include "markov_test.h"
+
+//The results of a non-IID assessment
+struct non_iid_result {
+	double H_original;
+	double H_bitstring;
+	double h_assessed;
+	//Every estimate, in the order that they are run
+	vector<double> estimates;
+};
+
+//The scratch memory needed by the estimators for data; the largest users are the suffix array
+//estimators and the binary dictionaries of the predictors
+size_t non_iid_scratch_size(const data_t *data);
+
+//Runs the non-IID estimators on already loaded data. The estimators' scratch memory comes from
+//scratch if it is given.
+void non_iid_assess(data_t *data, bool initial_entropy, int verbose, struct non_iid_result *result, struct arena *scratch = NULL);
@@ -8,6 +8,10 @@
 #include "non_iid/multi_mcw_test.h"
 #include "non_iid/compression_test.h"
 #include "non_iid/markov_test.h"
+#include "non_iid/non_iid_assess.h"
+#include "iid/chi_square_tests.h"
+#include "shared/stream.h"
+#include "shared/profile.h"
 
 #include <pthread.h>
 #include <getopt.h>
@@ -41,6 +45,24 @@ static int __verbose;
     printf("\t Note: When testing binary data, no `H_bitstring` assessment is produced, so the `-a` and `-t` options produce the same results for the initial assessment of binary data.\n");
     printf("\t -v: Optional verbosity flag for more output. Can be used multiple times.\n");
     printf("\t -l <index>,<samples>\tRead the <index> substring of length <samples>.\n");
+    printf("\t -l <first>-<last>,<samples> or -l all,<samples>: Sweep the substrings <first> to <last> (or all of them),\n");
+    printf("\t printing one result line per substring. -l may be given several times to sweep a list of substrings.\n");
+    printf("\t The file is read once, and the substrings are assessed <threads> at a time (see -j).\n");
+    printf("\n");
+    printf("\t Streaming mode: ea_non_iid -w <window> [-s <stride>] [-f] [-m] [-j <threads>] [-q <depth>] [--profile <file>] [-i|-c] [-a|-t] <file_name>|- [bits_per_symbol]\n");
+    printf("\t -w <window>: Assess successive windows of <window> samples read from <file_name> (or standard input for '-'),\n");
+    printf("\t printing one result line per window. Without -w, -s, -f or -m, the whole file is assessed at once.\n");
+    printf("\t -s <stride>: The number of samples between the starts of successive windows. By default, the windows don't overlap.\n");
+    printf("\t -f: Follow a growing file, waiting for more samples at the end of the file rather than stopping.\n");
+    printf("\t -m: Monitoring mode. Only the estimates that can be updated as the window slides (the MCV estimate, and the\n");
+    printf("\t MCV and Markov estimates of the bit string) are computed, so each window costs time proportional to the stride.\n");
+    printf("\t The chi-square independence score is printed for a window once every <window> samples, and the MultiMCW\n");
+    printf("\t estimate is made for the whole stream so far (it depends on every earlier prediction, so it can't be\n");
+    printf("\t made for the window alone).\n");
+    printf("\t -j <threads>: The number of windows assessed at once. Defaults to the number of processors.\n");
+    printf("\t -q <depth>: The number of windows read ahead of the assessment. Defaults to the number of threads.\n");
+    printf("\t --profile <file>: Append a JSON record of the time, memory and work taken by each estimator over the run\n");
+    printf("\t to <file> ('-' for standard error). Setting EA_PROFILE to a file name does the same.\n");
     printf("\n");
     printf("\t Samples are assumed to be packed into 8-bit values, where the least significant 'bits_per_symbol'\n");
     printf("\t bits constitute the symbol.\n");
@@ -68,11 +90,10 @@ void *func(void *params) {
     bool initial_entropy, all_bits;
     int verbose = 0;
     char *file_path;
-    double H_original, H_bitstring, ret_min_entropy;
+    double H_original, H_bitstring;
     data_t data;
     int opt;
-    double bin_t_tuple_res = -1.0, bin_lrs_res = -1.0;
-    double t_tuple_res = -1.0, lrs_res = -1.0;
+    struct non_iid_result result;
     unsigned long subsetIndex = ULONG_MAX;
     unsigned long subsetSize = 0;
     unsigned long long inint;
@@ -119,241 +140,11 @@ void *func(void *params) {
         if (data.alph_size < (1 << data.word_size)) printf("\nSymbols have been translated.\n");
     }
 
-    // The maximum min-entropy is -log2(1/2^word_size) = word_size
-    // The maximum bit string min-entropy is 1.0
-    H_original = data.word_size;
-    H_bitstring = 1.0;
-
-    if (verbose > 0) {
-        printf("\nRunning non-IID tests...\n\n");
-        printf("Running Most Common Value Estimate...\n");
-    }
-
-    // Section 6.3.1 - Estimate entropy with Most Common Value
-    if (((data.alph_size > 2) || !initial_entropy)) {
-        ret_min_entropy = most_common(data.bsymbols, data.blen, 2, verbose, "Bitstring");
-
-        if (verbose > 0) printf("\tMost Common Value Estimate (bit string) = %f / 1 bit(s)\n", ret_min_entropy);
-        H_bitstring = min(ret_min_entropy, H_bitstring);
-
-        log_to_file(&ret_min_entropy, false, i, thread_data->outdir);
-    }
-
-    if (initial_entropy) {
-        ret_min_entropy = most_common(data.symbols, data.len, data.alph_size, verbose, "Literal");
-        if (verbose > 0)
-            printf("\tMost Common Value Estimate = %f / %d bit(s)\n", ret_min_entropy, data.word_size);
-        H_original = min(ret_min_entropy, H_original);
-
-        log_to_file(&ret_min_entropy, false, i, thread_data->outdir);
-    }
-
-    if (verbose > 0) printf("\nRunning Entropic Statistic Estimates (bit strings only)...\n");
-
-    // Section 6.3.2 - Estimate entropy with Collision Test (for bit strings only)
-    if (((data.alph_size > 2) || !initial_entropy)) {
-        ret_min_entropy = collision_test(data.bsymbols, data.blen, verbose, "Bitstring");
-
-        if (verbose > 0) printf("\tCollision Test Estimate (bit string) = %f / 1 bit(s)\n", ret_min_entropy);
-        H_bitstring = min(ret_min_entropy, H_bitstring);
-
-        log_to_file(&ret_min_entropy, false, i, thread_data->outdir);
-    }
-
-    if (initial_entropy && (data.alph_size == 2)) {
-        ret_min_entropy = collision_test(data.symbols, data.len, verbose, "Literal");
-
-        if (verbose > 0) printf("\tCollision Test Estimate = %f / 1 bit(s)\n", ret_min_entropy);
-        H_original = min(ret_min_entropy, H_original);
-
-        log_to_file(&ret_min_entropy, false, i, thread_data->outdir);
-    }
-
-    // Section 6.3.3 - Estimate entropy with Markov Test (for bit strings only)
-    if (((data.alph_size > 2) || !initial_entropy)) {
-        ret_min_entropy = markov_test(data.bsymbols, data.blen, verbose, "Bitstring");
-
-        if (verbose > 0) printf("\tMarkov Test Estimate (bit string) = %f / 1 bit(s)\n", ret_min_entropy);
-        H_bitstring = min(ret_min_entropy, H_bitstring);
-
-        log_to_file(&ret_min_entropy, false, i, thread_data->outdir);
-    }
-
-    if (initial_entropy && (data.alph_size == 2)) {
-        ret_min_entropy = markov_test(data.symbols, data.len, verbose, "Literal");
-
-        if (verbose > 0) printf("\tMarkov Test Estimate = %f / 1 bit(s)\n", ret_min_entropy);
-        H_original = min(ret_min_entropy, H_original);
-
-        log_to_file(&ret_min_entropy, false, i, thread_data->outdir);
-    }
-
-    // Section 6.3.4 - Estimate entropy with Compression Test (for bit strings only)
-    if (((data.alph_size > 2) || !initial_entropy)) {
-        ret_min_entropy = compression_test(data.bsymbols, data.blen, verbose, "Bitstring");
-
-        if (ret_min_entropy >= 0) {
-            if (verbose > 0) printf("\tCompression Test Estimate (bit string) = %f / 1 bit(s)\n", ret_min_entropy);
-            H_bitstring = min(ret_min_entropy, H_bitstring);
-        }
-
-        log_to_file(&ret_min_entropy, false, i, thread_data->outdir);
-    }
-
-    if (initial_entropy && (data.alph_size == 2)) {
-        ret_min_entropy = compression_test(data.symbols, data.len, verbose, "Literal");
-
-        if (verbose > 0) printf("\ttCompression Test Estimate = %f / 1 bit(s)\n", ret_min_entropy);
-        H_original = min(ret_min_entropy, H_original);
-
-        log_to_file(&ret_min_entropy, false, i, thread_data->outdir);
-    }
-
-    if (verbose > 0) printf("\nRunning Tuple Estimates...\n");
-
-    // Section 6.3.5 - Estimate entropy with t-Tuple Test
-
-    if (((data.alph_size > 2) || !initial_entropy)) {
-        SAalgs(data.bsymbols, data.blen, 2, bin_t_tuple_res, bin_lrs_res, verbose, "Bitstring");
-        if (bin_t_tuple_res >= 0.0) {
-            if (verbose > 0) printf("\tT-Tuple Test Estimate (bit string) = %f / 1 bit(s)\n", bin_t_tuple_res);
-            H_bitstring = min(bin_t_tuple_res, H_bitstring);
-        }
-
-        log_to_file(&bin_t_tuple_res, false, i, thread_data->outdir);
-
-    }
-
-    if (initial_entropy) {
-        SAalgs(data.symbols, data.len, data.alph_size, t_tuple_res, lrs_res, verbose, "Literal");
-        if (t_tuple_res >= 0.0) {
-            if (verbose > 0) printf("\tT-Tuple Test Estimate = %f / %d bit(s)\n", t_tuple_res, data.word_size);
-            H_original = min(t_tuple_res, H_original);
-        }
-
-        log_to_file(&t_tuple_res, false, i, thread_data->outdir);
-    }
-
-    // Section 6.3.6 - Estimate entropy with LRS Test
-    if (((data.alph_size > 2) || !initial_entropy)) {
-        if (verbose > 0) printf("\tLRS Test Estimate (bit string) = %f / 1 bit(s)\n", bin_lrs_res);
-        H_bitstring = min(bin_lrs_res, H_bitstring);
-
-        log_to_file(&bin_lrs_res, false, i, thread_data->outdir);
-    }
-
+    non_iid_assess(&data, initial_entropy, verbose, &result);
+    H_original = result.H_original;
+    H_bitstring = result.H_bitstring;
+    for (size_t j = 0; j < result.estimates.size(); j++) log_to_file(&result.estimates[j], false, i, thread_data->outdir);
 
-    if (initial_entropy) {
-        if (verbose > 0) printf("\tLRS Test Estimate = %f / %d bit(s)\n", lrs_res, data.word_size);
-        H_original = min(lrs_res, H_original);
-
-        log_to_file(&lrs_res, false, i, thread_data->outdir);
-    }
-
-    if (verbose > 0) printf("\nRunning Predictor Estimates...\n");
-
-    if (((data.alph_size > 2) || !initial_entropy)) {
-        // Section 6.3.7 - Estimate entropy with Multi Most Common in Window Test
-        ret_min_entropy = multi_mcw_test(data.bsymbols, data.blen, 2, verbose, "Bitstring");
-
-        if (ret_min_entropy >= 0) {
-            if (verbose > 0)
-                printf("\tMulti Most Common in Window (MultiMCW) Prediction Test Estimate (bit string) = %f / 1 bit(s)\n", ret_min_entropy);
-            H_bitstring = min(ret_min_entropy, H_bitstring);
-        }
-
-        log_to_file(&ret_min_entropy, false, i, thread_data->outdir);
-    }
-
-    if (initial_entropy) {
-        ret_min_entropy = multi_mcw_test(data.symbols, data.len, data.alph_size, verbose, "Literal");
-
-        if (ret_min_entropy >= 0) {
-            if (verbose > 0)
-                printf("\tMulti Most Common in Window (MultiMCW) Prediction Test Estimate = %f / %d bit(s)\n",
-                       ret_min_entropy, data.word_size);
-            H_original = min(ret_min_entropy, H_original);
-        }
-
-        log_to_file(&ret_min_entropy, false, i, thread_data->outdir);
-    }
-
-    // Section 6.3.8 - Estimate entropy with Lag Prediction Test
-    if (((data.alph_size > 2) || !initial_entropy)) {
-        ret_min_entropy = lag_test(data.bsymbols, data.blen, 2, verbose, "Bitstring");
-
-        if (ret_min_entropy >= 0) {
-            if (verbose > 0)
-                printf("\tLag Prediction Test Estimate (bit string) = %f / 1 bit(s)\n", ret_min_entropy);
-            H_bitstring = min(ret_min_entropy, H_bitstring);
-        }
-
-        log_to_file(&ret_min_entropy, false, i, thread_data->outdir);
-    }
-
-    if (initial_entropy) {
-        ret_min_entropy = lag_test(data.symbols, data.len, data.alph_size, verbose, "Literal");
-
-        if (ret_min_entropy >= 0) {
-            if (verbose > 0)
-                printf("\tLag Prediction Test Estimate = %f / %d bit(s)\n", ret_min_entropy, data.word_size);
-            H_original = min(ret_min_entropy, H_original);
-        }
-
-        log_to_file(&ret_min_entropy, false, i, thread_data->outdir);
-    }
-
-    // Section 6.3.9 - Estimate entropy with Multi Markov Model with Counting Test (MultiMMC)
-    if (((data.alph_size > 2) || !initial_entropy)) {
-        ret_min_entropy = multi_mmc_test(data.bsymbols, data.blen, 2, verbose, "Bitstring");
-
-        if (ret_min_entropy >= 0) {
-            if (verbose > 0)
-                printf("\tMulti Markov Model with Counting (MultiMMC) Prediction Test Estimate (bit string) = %f / 1 bit(s)\n",
-                       ret_min_entropy);
-            H_bitstring = min(ret_min_entropy, H_bitstring);
-        }
-
-        log_to_file(&ret_min_entropy, false, i, thread_data->outdir);
-    }
-
-    if (initial_entropy) {
-        ret_min_entropy = multi_mmc_test(data.symbols, data.len, data.alph_size, verbose, "Literal");
-
-        if (ret_min_entropy >= 0) {
-            if (verbose > 0)
-                printf("\tMulti Markov Model with Counting (MultiMMC) Prediction Test Estimate = %f / %d bit(s)\n",
-                       ret_min_entropy, data.word_size);
-            H_original = min(ret_min_entropy, H_original);
-        }
-
-        log_to_file(&ret_min_entropy, false, i, thread_data->outdir);
-    }
-
-    // Section 6.3.10 - Estimate entropy with LZ78Y Test
-    if (((data.alph_size > 2) || !initial_entropy)) {
-        ret_min_entropy = LZ78Y_test(data.bsymbols, data.blen, 2, verbose, "Bitstring");
-
-        if (ret_min_entropy >= 0) {
-            if (verbose > 0)
-                printf("\tLZ78Y Prediction Test Estimate (bit string) = %f / 1 bit(s)\n", ret_min_entropy);
-            H_bitstring = min(ret_min_entropy, H_bitstring);
-        }
-
-        log_to_file(&ret_min_entropy, false, i, thread_data->outdir);
-    }
-
-    if (initial_entropy) {
-        ret_min_entropy = LZ78Y_test(data.symbols, data.len, data.alph_size, verbose, "Literal");
-
-        if (ret_min_entropy >= 0) {
-            if (verbose > 0)
-                printf("\tLZ78Y Prediction Test Estimate = %f / %d bit(s)\n", ret_min_entropy, data.word_size);
-            H_original = min(ret_min_entropy, H_original);
-        }
-
-        log_to_file(&ret_min_entropy, false, i, thread_data->outdir);
-    }
     verbose = 0;
     if (verbose > 0) {
         printf("\n");
@@ -506,7 +297,363 @@ int driver(const char *indir, const char *outdir, bool initial_entropy) {
     return 0;
 }
 
-int main () {
+//The settings shared by every window in streaming mode
+struct non_iid_stream_context {
+    int word_size;
+    bool initial_entropy;
+    bool all_bits;
+};
+
+void non_iid_assess_window(const struct stream_window *window, void *context, char *record, size_t record_len) {
+    struct non_iid_stream_context *settings = (struct non_iid_stream_context *)context;
+    struct non_iid_result result;
+    data_t data;
+
+    data.word_size = settings->word_size;
+    if (!read_buffer(window->samples.data(), window->samples.size(), &data)) {
+        snprintf(record, record_len, "Window %ld (samples %ld-%ld): Error reading samples", window->index, window->offset, window->offset + (long)window->samples.size() - 1);
+        return;
+    }
+
+    if (data.alph_size <= 1) {
+        snprintf(record, record_len, "Window %ld (samples %ld-%ld): Symbol alphabet consists of 1 symbol. No entropy awarded", window->index, window->offset, window->offset + data.len - 1);
+        free_data(&data);
+        return;
+    }
+
+    if (!settings->all_bits && (data.blen > MIN_SIZE)) data.blen = MIN_SIZE;
+
+    non_iid_assess(&data, settings->initial_entropy, 0, &result);
+
+    if (settings->initial_entropy) {
+        snprintf(record, record_len, "Window %ld (samples %ld-%ld): H_original = %.17g, H_bitstring = %.17g, Assessed min entropy: %.17g",
+                 window->index, window->offset, window->offset + data.len - 1, result.H_original, result.H_bitstring, result.h_assessed);
+    } else {
+        snprintf(record, record_len, "Window %ld (samples %ld-%ld): h' = %.17g, Assessed min entropy: %.17g",
+                 window->index, window->offset, window->offset + data.len - 1, result.H_bitstring, result.h_assessed);
+    }
+
+    free_data(&data);
+}
+
+//The running state of monitoring mode, where only the estimators that can be updated incrementally are run
+struct non_iid_monitor_context {
+    int word_size;
+    //The masked samples and their bits. As in stream_monitor, the window slides along buffers about twice its
+    //length, and is moved back to their start once every window_len samples.
+    vector<byte> symbols;
+    vector<byte> bits;
+    long start;     // the first sample of the current window
+    struct mcv_counts literal_counts;
+    struct mcv_counts bit_counts;
+    struct markov_counts transitions;
+    //Binning the pairs of symbols for the independence score costs O(2^(2*word_size)), so to keep the cost of
+    //each step proportional to the stride, the score is only printed once every window_len samples
+    struct independence_counts pairs;
+    long next_independence;
+    //The MultiMCW predictor can't drop samples from the front of the window, so it's checkpointed and advanced
+    //over the whole stream instead. It's only run if the window holds the history that the predictor needs.
+    bool run_mcw;
+    struct mcw_state mcw;
+};
+
+//Masks count samples to word_size bits and expands them into bits, storing them from position dest on
+void monitor_convert(struct non_iid_monitor_context *state, const byte *samples, long dest, long count) {
+    int mask = (1 << state->word_size) - 1;
+
+    for (long i = 0; i < count; i++) {
+        state->symbols[dest + i] = samples[i] & mask;
+        for (int j = 0; j < state->word_size; j++) {
+            state->bits[(dest + i) * state->word_size + j] = (state->symbols[dest + i] >> (state->word_size - 1 - j)) & 0x1;
+        }
+    }
+}
+
+void non_iid_monitor_window(const byte *samples, long window_len, long stride, long index, long offset, void *context) {
+    struct non_iid_monitor_context *state = (struct non_iid_monitor_context *)context;
+    int word_size, df;
+    double H_original, H_bitstring, h_assessed, independence;
+    char independence_record[STREAM_RECORD_MAX], mcw_record[STREAM_RECORD_MAX];
+
+    if (index == 0) {
+        if (state->word_size == 0) state->word_size = max(symbol_bit_width(samples, window_len), 1);
+        state->symbols.resize(2 * window_len + stride);
+        state->bits.resize((2 * window_len + stride) * state->word_size);
+        state->start = 0;
+
+        monitor_convert(state, samples, 0, window_len);
+        mcv_counts_init(&state->literal_counts, state->symbols.data(), window_len, 1 << state->word_size);
+        mcv_counts_init(&state->bit_counts, state->bits.data(), window_len * state->word_size, 2);
+        markov_counts_init(&state->transitions, state->bits.data(), window_len * state->word_size);
+        independence_counts_init(&state->pairs, state->symbols.data(), window_len, 1 << state->word_size);
+        state->next_independence = 0;
+
+        state->run_mcw = (window_len > MCW_WINDOWS[NUM_WINS-1]);
+        if (state->run_mcw) {
+            mcw_init(&state->mcw, state->symbols.data(), 1 << state->word_size);
+            mcw_advance(&state->mcw, state->symbols.data(), 0, window_len);
+        }
+    } else {
+        byte *window_symbols = state->symbols.data() + state->start;
+        byte *window_bits = state->bits.data() + state->start * state->word_size;
+
+        monitor_convert(state, samples + window_len, state->start + window_len, stride);
+        mcv_counts_slide(&state->literal_counts, window_symbols, stride);
+        mcv_counts_slide(&state->bit_counts, window_bits, stride * state->word_size);
+        markov_counts_slide(&state->transitions, window_bits, stride * state->word_size);
+        independence_counts_slide(&state->pairs, window_symbols, stride);
+        if (state->run_mcw) mcw_advance(&state->mcw, window_symbols, offset - stride, offset + window_len);
+
+        state->start += stride;
+        if (state->start + window_len + stride > (long)state->symbols.size()) {
+            memmove(state->symbols.data(), state->symbols.data() + state->start, window_len);
+            memmove(state->bits.data(), state->bits.data() + state->start * state->word_size, window_len * state->word_size);
+            state->start = 0;
+        }
+    }
+
+    word_size = state->word_size;
+    H_original = most_common_incremental(&state->literal_counts, 0, "Literal");
+    H_bitstring = min(most_common_incremental(&state->bit_counts, 0, "Bitstring"), markov_incremental(&state->transitions, 0, "Bitstring"));
+    h_assessed = min(H_original, word_size * H_bitstring);
+
+    independence_record[0] = '\0';
+    if (offset >= state->next_independence) {
+        chi_square_independence_incremental(&state->pairs, independence, df);
+        snprintf(independence_record, sizeof(independence_record), ", Independence chi-square = %.17g (%d df)", independence, df);
+        state->next_independence = offset + window_len;
+    }
+
+    mcw_record[0] = '\0';
+    if (state->run_mcw) {
+        snprintf(mcw_record, sizeof(mcw_record), ", MultiMCW (samples 0-%ld) = %.17g", offset + window_len - 1, mcw_estimate(&state->mcw, 0, "Literal"));
+    }
+
+    printf("Window %ld (samples %ld-%ld): MCV = %.17g, H_bitstring (MCV, Markov) = %.17g, Monitored min entropy: %.17g%s%s\n",
+           index, offset, offset + window_len - 1, H_original, H_bitstring, h_assessed, independence_record, mcw_record);
+    fflush(stdout);
+}
+
+//Assesses the whole file, or the subset of it given by subsetIndex and subsetSize, printing the estimates as they are made
+int non_iid_file(const char *file_path, unsigned long subsetIndex, unsigned long subsetSize, const struct non_iid_stream_context *settings, int verbose) {
+    struct non_iid_result result;
+    data_t data;
+    bool loaded;
+
+    data.word_size = settings->word_size;
+
+    if (verbose > 0) printf("Opening file: '%s'\n", file_path);
+
+    {
+        ProfileScope profile("read_file", NULL, 0);
+        loaded = read_file_subset(file_path, &data, subsetIndex, subsetSize);
+    }
+    if (!loaded) {
+        printf("Error reading file.\n");
+        print_usage();
+    }
+    profile_set_input(data.len, data.word_size);
+
+    if (verbose > 0)
+        printf("Loaded %ld samples of %d distinct %d-bit-wide symbols\n", data.len, data.alph_size, data.word_size);
+
+    if (data.alph_size <= 1) {
+        printf("Symbol alphabet consists of 1 symbol. No entropy awarded...\n");
+        free_data(&data);
+        exit(-1);
+    }
+
+    if (!settings->all_bits && (data.blen > MIN_SIZE)) data.blen = MIN_SIZE;
+
+    if ((verbose > 0) && ((data.alph_size > 2) || !settings->initial_entropy))
+        printf("Number of Binary Symbols: %ld\n", data.blen);
+    if (data.len < MIN_SIZE) printf("\n*** Warning: data contains less than %d samples ***\n\n", MIN_SIZE);
+    if (verbose > 0) {
+        if (data.alph_size < (1 << data.word_size)) printf("\nSymbols have been translated.\n");
+    }
+
+    non_iid_assess(&data, settings->initial_entropy, verbose, &result);
+
+    if (verbose <= 1) {
+        printf("\n");
+        if (settings->initial_entropy) {
+            printf("H_original: %f\n", result.H_original);
+            if (data.alph_size > 2) {
+                printf("H_bitstring: %f\n\n", result.H_bitstring);
+                printf("min(H_original, %d X H_bitstring): %f\n\n", data.word_size, min(result.H_original, data.word_size * result.H_bitstring));
+            }
+        } else {
+            printf("h': %f\n", result.H_bitstring);
+        }
+    } else {
+        if ((data.alph_size > 2) || !settings->initial_entropy) printf("H_bitstring = %.17g\n", result.H_bitstring);
+        if (settings->initial_entropy) printf("H_original: %.17g\n", result.H_original);
+        printf("Assessed min entropy: %.17g\n", result.h_assessed);
+    }
+
+    free_data(&data);
+    return 0;
+}
+
+//Assesses a whole file (or one subset of it) as before, or with -w, -s, -f or -m, streams fixed size windows
+//read from a file, a pipe, or a growing file
+int non_iid_stream(int argc, char *argv[]) {
+    struct non_iid_stream_context settings;
+    long window_len = MIN_SIZE, stride = 0;
+    bool streaming = false;
+    int verbose = 0;
+    long windows;
+    int worker_count = get_nprocs();
+    long queue_depth = 0;
+    bool follow = false;
+    bool monitor = false;
+    struct slice_range range;
+    vector<struct slice_range> ranges;
+    const char *profile_path = NULL;
+    int opt;
+    //The long options only; their values are outside the range of the short options' characters
+    static const struct option long_options[] = {
+        {"profile", required_argument, NULL, 256},
+        {NULL, 0, NULL, 0}
+    };
+
+    settings.word_size = 0;
+    settings.initial_entropy = true;
+    settings.all_bits = true;
+
+    while ((opt = getopt_long(argc, argv, "icatvl:w:s:fj:q:m", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'i':
+                settings.initial_entropy = true;
+                break;
+            case 'c':
+                settings.initial_entropy = false;
+                break;
+            case 'a':
+                settings.all_bits = true;
+                break;
+            case 't':
+                settings.all_bits = false;
+                break;
+            case 'v':
+                //Only the whole file assessment prints the estimates; the output of concurrent windows would be interleaved.
+                verbose++;
+                break;
+            case 'l':
+                if (!parse_slice_range(optarg, &range)) print_usage();
+                ranges.push_back(range);
+                break;
+            case 'w':
+                window_len = strtol(optarg, NULL, 0);
+                if (window_len <= 0) print_usage();
+                streaming = true;
+                break;
+            case 's':
+                stride = strtol(optarg, NULL, 0);
+                if (stride <= 0) print_usage();
+                streaming = true;
+                break;
+            case 'f':
+                follow = true;
+                streaming = true;
+                break;
+            case 'm':
+                monitor = true;
+                streaming = true;
+                break;
+            case 'j':
+                worker_count = atoi(optarg);
+                if (worker_count <= 0) print_usage();
+                break;
+            case 'q':
+                queue_depth = strtol(optarg, NULL, 0);
+                if (queue_depth <= 0) print_usage();
+                break;
+            case 256:
+                profile_path = optarg;
+                break;
+            default:
+                print_usage();
+        }
+    }
+
+    argc -= optind;
+    argv += optind;
+
+    if ((argc != 1) && (argc != 2)) {
+        printf("Incorrect usage.\n");
+        print_usage();
+    }
+
+    if (argc == 2) {
+        settings.word_size = atoi(argv[1]);
+        if (settings.word_size < 1 || settings.word_size > 8) {
+            printf("Invalid bits per symbol.\n");
+            print_usage();
+        }
+    }
+
+    if (!profile_init("ea_non_iid", argv[0], profile_path)) exit(-1);
+
+    if (!ranges.empty() && streaming) {
+        printf("Streaming mode can't be combined with -l.\n");
+        print_usage();
+    }
+
+    //A single subset is assessed as a whole file is; several are swept in one process
+    if ((ranges.size() > 1) || ((ranges.size() == 1) && (ranges[0].last > ranges[0].first))) {
+        if ((windows = slice_assessment(argv[0], ranges, worker_count, non_iid_assess_window, &settings)) < 0) {
+            printf("Error reading file.\n");
+            print_usage();
+        }
+        if (windows == 0) {
+            printf("No substrings were read; they all start past the end of the file.\n");
+            exit(-1);
+        }
+        return 0;
+    }
+
+    if (!streaming) {
+        if (ranges.size() == 1) return non_iid_file(argv[0], ranges[0].first, ranges[0].subset_len, &settings, verbose);
+        return non_iid_file(argv[0], ULONG_MAX, 0, &settings, verbose);
+    }
+
+    if (stride == 0) stride = window_len;
+    if (queue_depth == 0) queue_depth = worker_count;
+    if (window_len < MIN_SIZE) printf("\n*** Warning: windows contain less than %d samples ***\n\n", MIN_SIZE);
+
+    if (monitor) {
+        struct non_iid_monitor_context state;
+
+        if (stride > window_len) {
+            printf("In monitoring mode, the stride can't be larger than the window.\n");
+            print_usage();
+        }
+
+        state.word_size = settings.word_size;
+        windows = stream_monitor(argv[0], window_len, stride, follow, non_iid_monitor_window, &state);
+    } else {
+        windows = stream_assessment(argv[0], window_len, stride, follow, worker_count, queue_depth, non_iid_assess_window, &settings);
+    }
+
+    if (windows < 0) {
+        printf("Error reading file.\n");
+        print_usage();
+    }
+    if (windows == 0) {
+        printf("No windows were read; the input has fewer than %ld samples.\n", window_len);
+        exit(-1);
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    //With arguments, assess the named file; otherwise, assess the configured sample directories.
+    if (argc > 1) return non_iid_stream(argc, argv);
+
+    if (!profile_init("ea_non_iid", "data", NULL)) exit(-1);
+
     printf("started\n");
 #if __BINARY_DATA__
 #if __INITIAL_ENTROPY__
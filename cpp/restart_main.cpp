@@ -1,4 +1,5 @@
 #include "shared/utils.h"
+#include "shared/transpose.h"
 #include "shared/most_common.h"
 #include "shared/lrs_test.h"
 #include "non_iid/collision_test.h"
@@ -8,20 +9,36 @@
 #include "non_iid/multi_mcw_test.h"
 #include "non_iid/compression_test.h"
 #include "non_iid/markov_test.h"
+#include "shared/profile.h"
 
 #include <getopt.h>
+#include <sys/file.h>	// flock
 
 //Each test has a targeted chance of roughly 0.000005, and we need to witness at least 5 failures, so this should be no less than 1000000
 #define SIMULATION_ROUNDS 5000000
 
+//The simulation rounds are split into this many blocks (which must divide SIMULATION_ROUNDS), each drawing from
+//its own random stream, so that the simulated cutoff depends only on the seed and not on the number of threads
+#define SIMULATION_BLOCKS 250
+
+//The default number of decimal places H_I is rounded to when using the cutoff cache
+#define DEFAULT_CACHE_PRECISION 3
+
 [[ noreturn ]] void print_usage(){
-	printf("Usage is: ea_restart [-i|-n] [-v] <file_name> [bits_per_symbol] <H_I>\n\n");
+	printf("Usage is: ea_restart [-i|-n] [-a] [-b] [-c <cache_file> [-g] [-p <precision>]] [-v] [--profile <file>] <file_name> [bits_per_symbol] <H_I>\n\n");
 	printf("\t <file_name>: Must be relative path to a binary file with at least 1 million entries (samples),\n");
 	printf("\t and in the \"row dataset\" format described in SP800-90B Section 3.1.4.1.\n");
 	printf("\t [bits_per_symbol]: Must be between 1-8, inclusive.\n");
 	printf("\t <H_I>: Initial entropy estimate.\n");
 	printf("\t [-i|-n]: '-i' for IID data, '-n' for non-IID data. Non-IID is the default.\n");
+	printf("\t -a: Compute the sanity check cutoff analytically (using a union bound) rather than by simulation.\n");
+	printf("\t -b: Batch mode. Assess each 1000x1000 restart matrix in the file, with a summary line for each.\n");
+	printf("\t -c <cache_file>: Read the sanity check cutoff from (and record newly simulated cutoffs in) this file.\n");
+	printf("\t -g: Simulate the cutoff again even if it is in the cache file, and record the new value.\n");
+	printf("\t -p <precision>: The number of decimal places H_I is rounded up to when using the cache file (default %d).\n", DEFAULT_CACHE_PRECISION);
 	printf("\t -v: Optional verbosity flag for more output.\n");
+	printf("\t --profile <file>: Append a JSON record of the time, memory and work taken by each estimator and phase\n");
+	printf("\t of the run to <file> ('-' for standard error). Setting EA_PROFILE to a file name does the same.\n");
 	printf("\n");
 	printf("\t Restart samples are assumed to be packed into 8-bit values, where the rightmost 'bits_per_symbol'\n");
 	printf("\t bits constitute the sample.\n");
@@ -38,107 +55,775 @@
 	exit(-1);
 }
 
-//Here, we simulate a sort of "worst case" for this test, where there are a maximal number of symbols with maximal probability,
-//and the rest is distributed to the other symbols
-long int simulateCount(int k, double H_I, uint64_t *xoshiro256starstarState) {
-	long int counts[256];
-	int current_symbol;
+//The number of samples in each row or column of the restart data.
+#define RESTART_SAMPLES 1000
+
+//The parameters of the simulated "worst case" distribution; these depend only on k and H_I,
+//so they are computed once for all the simulation rounds.
+struct simulation_params {
+	int k;
 	int k_max;
-	long int max_count=0;
-	double p, max_cutoff, p_min, cur_rand;
+	double p;
+	double max_cutoff;
+	double p_min;
+};
+
+//Whether there is a distribution over k symbols with min-entropy H_I, which the cutoffs are found for;
+//this is the condition asserted by init_simulation_params
+bool cutoff_defined(int k, double H_I) {
+	return floor(1.0/pow(2.0, -H_I)) <= k;
+}
 
+void init_simulation_params(struct simulation_params *params, int k, double H_I) {
 	assert(k<=256);
 
-	p = pow(2.0, -H_I);
-
-	k_max = floor(1.0/p);
-
-	assert(k_max <= k);
+	params->k = k;
+	params->p = pow(2.0, -H_I);
+	params->k_max = floor(1.0/params->p);
 
+	assert(params->k_max <= k);
 
-	if(k>k_max) {
-		max_cutoff = p * k_max;
-		p_min = (1.0-max_cutoff)/(k-k_max);
+	if(k>params->k_max) {
+		params->max_cutoff = params->p * params->k_max;
+		params->p_min = (1.0-params->max_cutoff)/(k-params->k_max);
 	} else {
-		max_cutoff = 1.0;
-		p_min = 0.0;
+		params->max_cutoff = 1.0;
+		params->p_min = 0.0;
 	}
+}
+
+//Here, we simulate a sort of "worst case" for this test, where there are a maximal number of symbols with maximal probability,
+//and the rest is distributed to the other symbols
+long int simulateCount(const struct simulation_params *params, struct random_stream *rs) {
+	long int counts[256];
+	double draws[RESTART_SAMPLES];
+	int current_symbol;
+	long int max_count=0;
+	double cur_rand;
 
-	for(int j=0; j<k; j++) counts[j] = 0;
+	//Draw all the variates up front, so that the generator runs uninterrupted.
+	for(int j=0; j<RESTART_SAMPLES; j++) draws[j] = randomUnit(rs);
 
-	for(int j=0; j<1000; j++) {
-		cur_rand = randomUnit(xoshiro256starstarState);
-		if(cur_rand < max_cutoff) {
-			current_symbol = floor(cur_rand / p);
-			assert((current_symbol >= 0) && (current_symbol < k_max));
+	for(int j=0; j<params->k; j++) counts[j] = 0;
+
+	for(int j=0; j<RESTART_SAMPLES; j++) {
+		cur_rand = draws[j];
+		if(cur_rand < params->max_cutoff) {
+			current_symbol = floor(cur_rand / params->p);
+			assert((current_symbol >= 0) && (current_symbol < params->k_max));
 		} else {
-			current_symbol = floor((cur_rand-max_cutoff) / p_min) + k_max;
-			assert((current_symbol >= k_max) && (current_symbol < k));
+			current_symbol = floor((cur_rand-params->max_cutoff) / params->p_min) + params->k_max;
+			assert((current_symbol >= params->k_max) && (current_symbol < params->k));
 		}
 		counts[current_symbol]++;
 	}
 
-	for(int j=0; j<k; j++) {
+	for(int j=0; j<params->k; j++) {
 		if(max_count < counts[j]) max_count = counts[j];
 	}
 
 	return max_count;
 }
 
+//A simulated cutoff, along with the seed that produced it.
+struct simulated_bound {
+	long int X_cutoff;
+	uint64_t seed[4];
+};
+
+//Cutoffs already found in this process, keyed by (k, H_I, alpha).
+static map<array<double, 3>, struct simulated_bound> bound_cache;
+static mutex bound_cache_mutex;
+
 //This returns the bound (cutoff) for the test. Counts equal to this value should pass.
 //Larger values should fail.
-long int simulateBound(double alpha, int k, double H_I){
+//If seedUsed is not NULL, the seed of the simulation is written there.
+long int simulateBound(double alpha, int k, double H_I, uint64_t *seedUsed = NULL){
 	uint64_t xoshiro256starstarMainSeed[4];
-	vector<long int> results(SIMULATION_ROUNDS, -1);
-	long int returnIndex;
+	struct simulation_params params;
+	struct simulated_bound result;
+	//histogram[i] is the number of simulation rounds whose maximum count was i
+	vector<long int> histogram(RESTART_SAMPLES+1, 0);
+	array<double, 3> cacheKey = {{(double)k, H_I, alpha}};
+	long int returnIndex, cumulative, bound;
 
 	assert((k>1) && (k<=256));
 
-	seed(xoshiro256starstarMainSeed);
+	{
+		lock_guard<mutex> lock(bound_cache_mutex);
+		map<array<double, 3>, struct simulated_bound>::iterator cached = bound_cache.find(cacheKey);
+		if(cached != bound_cache.end()) {
+			if(seedUsed != NULL) memcpy(seedUsed, cached->second.seed, sizeof(cached->second.seed));
+			return cached->second.X_cutoff;
+		}
+	}
+
+	init_simulation_params(&params, k, H_I);
+	if(!seed(xoshiro256starstarMainSeed)) exit(-1);
 
         #pragma omp parallel
 	{
-		uint64_t xoshiro256starstarSeed[4];
+		struct random_stream rs;
+		vector<long int> localHistogram(RESTART_SAMPLES+1, 0);
 
-		memcpy(xoshiro256starstarSeed, xoshiro256starstarMainSeed, sizeof(xoshiro256starstarMainSeed));
-		//Cause the RNG to jump omp_get_thread_num() * 2^128 calls
-		xoshiro_jump(omp_get_thread_num(), xoshiro256starstarSeed);
+		#pragma omp for schedule(dynamic)
+		for(int b = 0; b < SIMULATION_BLOCKS; b++){
+			//Each block's lanes start b * XOSHIRO_LANES * 2^128 calls into the RNG
+			random_stream_init(&rs, xoshiro256starstarMainSeed, b * XOSHIRO_LANES);
 
-		#pragma omp for
-		for(int i = 0; i < SIMULATION_ROUNDS; i++){
-			results[i] = simulateCount(k, H_I, xoshiro256starstarSeed);
+			for(int i = 0; i < SIMULATION_ROUNDS / SIMULATION_BLOCKS; i++){
+				localHistogram[simulateCount(&params, &rs)]++;
+			}
+		}
+
+		#pragma omp critical(restart_histogram)
+		{
+			for(int i = 0; i <= RESTART_SAMPLES; i++) histogram[i] += localHistogram[i];
 		}
 	}
 
-	sort(results.begin(), results.end());
-	assert((results[0]>=(1000/k)) && (results[0] <= 1000));
-	assert((results[SIMULATION_ROUNDS-1]>=(1000/k)) && (results[SIMULATION_ROUNDS-1] <= 1000));
-	assert(results[0] <= results[SIMULATION_ROUNDS-1]);
+	//The count can't be less than ceil(1000/k)
+	for(int i = 0; i < (RESTART_SAMPLES+k-1)/k; i++) assert(histogram[i] == 0);
 
 	returnIndex = ((size_t)floor((1.0 - alpha) * ((double)SIMULATION_ROUNDS))) - 1;
 	assert((returnIndex >= 0) && (returnIndex < SIMULATION_ROUNDS));
 
-	return(results[returnIndex]);
+	//Find the value that would be at position returnIndex if all the results were sorted.
+	cumulative = 0;
+	bound = RESTART_SAMPLES;
+	for(int i = 0; i <= RESTART_SAMPLES; i++) {
+		cumulative += histogram[i];
+		if(cumulative > returnIndex) {
+			bound = i;
+			break;
+		}
+	}
+
+	result.X_cutoff = bound;
+	memcpy(result.seed, xoshiro256starstarMainSeed, sizeof(xoshiro256starstarMainSeed));
+	if(seedUsed != NULL) memcpy(seedUsed, xoshiro256starstarMainSeed, sizeof(xoshiro256starstarMainSeed));
+
+	{
+		lock_guard<mutex> lock(bound_cache_mutex);
+		bound_cache[cacheKey] = result;
+	}
+
+	return(bound);
+}
+
+//The on-disk cutoff cache is a text file with one line per simulation:
+//	<k> <H_I> <alpha> <rounds> <seed[0]> <seed[1]> <seed[2]> <seed[3]> <X_cutoff>
+//where H_I is written with the configured number of decimal places, and the seed words are in hex.
+//The simulation's random streams depend only on the seed, so an entry can be checked by simulating it again
+//from its seed, with any number of threads.
+//Lines starting with '#' are ignored. New simulations are appended, so when there are several
+//matching lines, the last one is used.
+#define CUTOFF_CACHE_LINE_MAX 512
+
+//Round H_I up to the given number of decimal places. A larger H_I gives a smaller (stricter) cutoff,
+//so the cached cutoff is never more permissive than the one for the unrounded H_I. The rounded value
+//may be past log2(k); see cachedBound.
+double round_H_I(double H_I, int precision) {
+	double scale = pow(10.0, precision);
+
+	//Don't let representation error in H_I bump it up to the next step.
+	return ceil(H_I * scale - 1e-6) / scale;
+}
+
+//Returns true and sets X_cutoff if the cache file has an entry for (k, H_I, alpha) at the current round count.
+bool read_cutoff_cache(const char *cache_path, int k, double H_I, double alpha, int precision, long int *X_cutoff) {
+	FILE *cache_file;
+	char line[CUTOFF_CACHE_LINE_MAX];
+	char H_I_str[64], entry_H_I_str[64], entry_alpha_str[64], alpha_str[64];
+	int entry_k;
+	long int entry_rounds, entry_cutoff;
+	unsigned long long entry_seed[4];
+	bool found = false;
+
+	cache_file = fopen(cache_path, "r");
+	if(cache_file == NULL) return false;
+
+	flock(fileno(cache_file), LOCK_SH);
+
+	snprintf(H_I_str, sizeof(H_I_str), "%.*f", precision, H_I);
+	snprintf(alpha_str, sizeof(alpha_str), "%.17g", alpha);
+
+	while(fgets(line, sizeof(line), cache_file) != NULL) {
+		if(line[0] == '#') continue;
+		if(sscanf(line, "%d %63s %63s %ld %llx %llx %llx %llx %ld", &entry_k, entry_H_I_str, entry_alpha_str, &entry_rounds,
+			&entry_seed[0], &entry_seed[1], &entry_seed[2], &entry_seed[3], &entry_cutoff) != 9) continue;
+
+		if((entry_k == k) && (strcmp(entry_H_I_str, H_I_str) == 0) && (strcmp(entry_alpha_str, alpha_str) == 0) && (entry_rounds == SIMULATION_ROUNDS)) {
+			*X_cutoff = entry_cutoff;
+			found = true;
+		}
+	}
+
+	flock(fileno(cache_file), LOCK_UN);
+	fclose(cache_file);
+
+	return found;
+}
+
+//Appends an entry to the cache file. Several runs may share a cache file, so the append is done under an exclusive lock.
+bool write_cutoff_cache(const char *cache_path, int k, double H_I, double alpha, int precision, const uint64_t seed[4], long int X_cutoff) {
+	FILE *cache_file;
+
+	cache_file = fopen(cache_path, "a");
+	if(cache_file == NULL) return false;
+
+	flock(fileno(cache_file), LOCK_EX);
+	fprintf(cache_file, "%d %.*f %.17g %d %016llx %016llx %016llx %016llx %ld\n", k, precision, H_I, alpha, SIMULATION_ROUNDS,
+		(unsigned long long)seed[0], (unsigned long long)seed[1], (unsigned long long)seed[2], (unsigned long long)seed[3], X_cutoff);
+	fflush(cache_file);
+	flock(fileno(cache_file), LOCK_UN);
+	fclose(cache_file);
+
+	return true;
+}
+
+//Returns the simulated cutoff for (k, H_I, alpha), using the cache file if one is given.
+//When a cache file is given, H_I is first rounded up to the given precision. No distribution over k symbols
+//has more than log2(k) bits of min-entropy, so if the rounded H_I is past that, the cutoff is simulated at
+//log2(k) instead. The cache is still keyed on the rounded H_I, which (with k) determines the simulated value.
+long int cachedBound(double alpha, int k, double H_I, const char *cache_path, int precision, bool regenerate, int verbose) {
+	uint64_t seedUsed[4];
+	long int X_cutoff;
+
+	if(cache_path == NULL) return simulateBound(alpha, k, H_I);
+
+	H_I = round_H_I(H_I, precision);
+
+	if(!regenerate && read_cutoff_cache(cache_path, k, H_I, alpha, precision, &X_cutoff)) {
+		if(verbose > 0) printf("Using cached cutoff for k = %d, H_I = %.*f from '%s'\n", k, precision, H_I, cache_path);
+		return X_cutoff;
+	}
+
+	if(verbose > 0) printf("Simulating cutoff for k = %d, H_I = %.*f\n", k, precision, H_I);
+	X_cutoff = simulateBound(alpha, k, min(H_I, log2((double)k)), seedUsed);
+
+	if(!write_cutoff_cache(cache_path, k, H_I, alpha, precision, seedUsed, X_cutoff)) {
+		printf("Warning: could not write to the cutoff cache '%s'\n", cache_path);
+	}
+
+	return X_cutoff;
+}
+
+//Returns log(P(X > x)) for X ~ Binomial(n, p).
+double log_binomial_upper_tail(long int x, long int n, double p) {
+	long double logTerm, logSum;
+
+	if(x >= n) return -DBL_INFINITY;
+	if(p <= 0.0) return -DBL_INFINITY;
+
+	//Sum the terms from x+1 up to n in log space; the terms decay quickly once we are past the mean,
+	//and the largest term is the first one (as x is above the mean in every case that matters here).
+	logSum = -LDBL_MAX;
+	for(long int i = x+1; i <= n; i++) {
+		logTerm = lgammal(n+1.0L) - lgammal(i+1.0L) - lgammal(n-i+1.0L) + i*logl(p) + (n-i)*log1pl(-(long double)p);
+		if(logSum == -LDBL_MAX) logSum = logTerm;
+		else logSum = fmaxl(logSum, logTerm) + log1pl(expl(-fabsl(logSum - logTerm)));
+	}
+
+	return (double)logSum;
+}
+
+//This returns an analytic bound for the test, using a union bound over the symbols of the same "worst case"
+//distribution used in simulateBound: P(max count > x) <= sum_j P(count_j > x). The union bound overstates the
+//probability of the maximum exceeding x, so this cutoff is never smaller than the exact (1-alpha) quantile;
+//for the small alpha values used here the two agree closely, and no simulation is needed.
+long int analyticBound(double alpha, int k, double H_I){
+	struct simulation_params params;
+	double log_alpha, log_tail;
+
+	assert((k>1) && (k<=256));
+	init_simulation_params(&params, k, H_I);
+	log_alpha = log(alpha);
+
+	for(long int x = (RESTART_SAMPLES+k-1)/k; x < RESTART_SAMPLES; x++) {
+		log_tail = log(params.k_max) + log_binomial_upper_tail(x, RESTART_SAMPLES, params.p);
+		if(k > params.k_max) {
+			double log_other = log(k - params.k_max) + log_binomial_upper_tail(x, RESTART_SAMPLES, params.p_min);
+			if(!std::isinf(log_other)) log_tail = fmax(log_tail, log_other) + log1p(exp(-fabs(log_tail - log_other)));
+		}
+
+		if(log_tail <= log_alpha) return x;
+	}
+
+	return RESTART_SAMPLES;
+}
+
+//Indexes of the per-estimator results used in restart testing
+#define RESTART_MCV 0
+#define RESTART_COLLISION 1
+#define RESTART_MARKOV 2
+#define RESTART_COMPRESSION 3
+#define RESTART_TTUPLE 4
+#define RESTART_LRS 5
+#define RESTART_MULTI_MCW 6
+#define RESTART_LAG 7
+#define RESTART_MULTI_MMC 8
+#define RESTART_LZ78Y 9
+#define RESTART_ESTIMATORS 10
+
+//Folds an estimator's result into the running minimum H. Estimators that may fail to produce an estimate
+//(the compression and prediction estimates) return a negative value in that case, which is then skipped;
+//the others are always applied. The estimator's own verbose output, which was kept while it ran, is printed first.
+double reduce_estimate(double H, double estimate, const string &output, const char *name, int word_size, bool always_applies, int verbose) {
+	fputs(output.c_str(), stdout);
+	if(!always_applies && (estimate < 0)) return H;
+
+	if(verbose > 0) printf("\t%s = %f / %d bit(s)\n", name, estimate, word_size);
+	return min(estimate, H);
+}
+
+//Returns the largest number of times that any one symbol occurs within a single row of the (row-major) matrix
+long max_row_count(const byte *matrix, int rows, int cols) {
+	int counts[256];
+	long X_i, X_max;
+
+	X_max = 0;
+	for(int i = 0; i < rows; i++){ //row
+		memset(counts, 0, 256*sizeof(int));
+		X_i = 0;
+		for(int j = 0; j < cols; j++){//column
+			//[i*cols+j] is row i, column j
+			//So, we're fixing a row, and then iterate through various columns
+			if(++counts[matrix[i*cols+j]] > X_i) X_i = counts[matrix[i*cols+j]];
+		}
+		if(X_i > X_max) X_max = X_i;
+	}
+
+	return X_max;
+}
+
+//Keeps the verbose output of the estimator run in the enclosing scope, rather than printing it as it is
+//written, so that the output of estimators run as concurrent tasks can be printed in order once they are done
+class OutputCapture {
+public:
+	OutputCapture(string *output, bool active) : output(output), buffer(NULL), size(0), stream(NULL) {
+		//If no buffer can be had, the output is printed as it is written
+		if(active && ((stream = open_memstream(&buffer, &size)) != NULL)) verbose_stream = stream;
+	}
+
+	~OutputCapture() {
+		if(stream == NULL) return;
+
+		verbose_stream = NULL;
+		fclose(stream);
+		output->assign(buffer, size);
+		free(buffer);
+	}
+
+private:
+	string *output;
+	char *buffer;
+	size_t size;
+	FILE *stream;
+};
+
+//Runs the estimators on the row and column data, and lowers H_r and H_c to the smallest estimates found.
+//If report is false, the progress messages aren't printed.
+void restart_estimates(byte *rdata, byte *cdata, long len, int alph_size, int word_size, bool iid, int verbose, bool report, double *H_r, double *H_c) {
+	double row_results[RESTART_ESTIMATORS], col_results[RESTART_ESTIMATORS];
+	string row_output[RESTART_ESTIMATORS], col_output[RESTART_ESTIMATORS];
+
+	if(report) {
+		if(iid)	printf("\nRunning IID tests...\n\n");
+		else printf("\nRunning non-IID tests...\n\n");
+	}
+
+	// The rows and the columns are assessed independently, and each estimator is run as its own task.
+	// Each task keeps its verbose output, which is printed with the task's result below, in the order of SP800-90B.
+	for(int i = 0; i < RESTART_ESTIMATORS; i++) {
+		row_results[i] = -1.0;
+		col_results[i] = -1.0;
+	}
+
+	#pragma omp parallel
+	{
+		#pragma omp single
+		{
+			#pragma omp task
+			{
+				OutputCapture capture(&row_output[RESTART_MCV], verbose > 0);
+				row_results[RESTART_MCV] = most_common(rdata, len, alph_size, verbose, "Literal");
+			}
+			#pragma omp task
+			{
+				OutputCapture capture(&col_output[RESTART_MCV], verbose > 0);
+				col_results[RESTART_MCV] = most_common(cdata, len, alph_size, verbose, "Literal");
+			}
+
+			if(!iid){
+				if(alph_size == 2){
+					// Section 6.3.2 - Estimate entropy with Collision Test (for bit strings only)
+					#pragma omp task
+					{
+						OutputCapture capture(&row_output[RESTART_COLLISION], verbose > 0);
+						row_results[RESTART_COLLISION] = collision_test(rdata, len, verbose, "Literal");
+					}
+					#pragma omp task
+					{
+						OutputCapture capture(&col_output[RESTART_COLLISION], verbose > 0);
+						col_results[RESTART_COLLISION] = collision_test(cdata, len, verbose, "Literal");
+					}
+
+					// Section 6.3.3 - Estimate entropy with Markov Test (for bit strings only)
+					#pragma omp task
+					{
+						OutputCapture capture(&row_output[RESTART_MARKOV], verbose > 0);
+						row_results[RESTART_MARKOV] = markov_test(rdata, len, verbose, "Literal");
+					}
+					#pragma omp task
+					{
+						OutputCapture capture(&col_output[RESTART_MARKOV], verbose > 0);
+						col_results[RESTART_MARKOV] = markov_test(cdata, len, verbose, "Literal");
+					}
+
+					// Section 6.3.4 - Estimate entropy with Compression Test (for bit strings only)
+					#pragma omp task
+					{
+						OutputCapture capture(&row_output[RESTART_COMPRESSION], verbose > 0);
+						row_results[RESTART_COMPRESSION] = compression_test(rdata, len, verbose, "Literal");
+					}
+					#pragma omp task
+					{
+						OutputCapture capture(&col_output[RESTART_COMPRESSION], verbose > 0);
+						col_results[RESTART_COMPRESSION] = compression_test(cdata, len, verbose, "Literal");
+					}
+				}
+
+				// Sections 6.3.5 and 6.3.6 - Estimate entropy with the t-Tuple and LRS Tests
+				#pragma omp task
+				{
+					OutputCapture capture(&row_output[RESTART_TTUPLE], verbose > 0);
+					SAalgs(rdata, len, alph_size, row_results[RESTART_TTUPLE], row_results[RESTART_LRS], verbose, "Literal");
+				}
+				#pragma omp task
+				{
+					OutputCapture capture(&col_output[RESTART_TTUPLE], verbose > 0);
+					SAalgs(cdata, len, alph_size, col_results[RESTART_TTUPLE], col_results[RESTART_LRS], verbose, "Literal");
+				}
+
+				// Section 6.3.7 - Estimate entropy with Multi Most Common in Window Test
+				#pragma omp task
+				{
+					OutputCapture capture(&row_output[RESTART_MULTI_MCW], verbose > 0);
+					row_results[RESTART_MULTI_MCW] = multi_mcw_test(rdata, len, alph_size, verbose, "Literal");
+				}
+				#pragma omp task
+				{
+					OutputCapture capture(&col_output[RESTART_MULTI_MCW], verbose > 0);
+					col_results[RESTART_MULTI_MCW] = multi_mcw_test(cdata, len, alph_size, verbose, "Literal");
+				}
+
+				// Section 6.3.8 - Estimate entropy with Lag Prediction Test
+				#pragma omp task
+				{
+					OutputCapture capture(&row_output[RESTART_LAG], verbose > 0);
+					row_results[RESTART_LAG] = lag_test(rdata, len, alph_size, verbose, "Literal");
+				}
+				#pragma omp task
+				{
+					OutputCapture capture(&col_output[RESTART_LAG], verbose > 0);
+					col_results[RESTART_LAG] = lag_test(cdata, len, alph_size, verbose, "Literal");
+				}
+
+				// Section 6.3.9 - Estimate entropy with Multi Markov Model with Counting Test (MultiMMC)
+				#pragma omp task
+				{
+					OutputCapture capture(&row_output[RESTART_MULTI_MMC], verbose > 0);
+					row_results[RESTART_MULTI_MMC] = multi_mmc_test(rdata, len, alph_size, verbose, "Literal");
+				}
+				#pragma omp task
+				{
+					OutputCapture capture(&col_output[RESTART_MULTI_MMC], verbose > 0);
+					col_results[RESTART_MULTI_MMC] = multi_mmc_test(cdata, len, alph_size, verbose, "Literal");
+				}
+
+				// Section 6.3.10 - Estimate entropy with LZ78Y Test
+				#pragma omp task
+				{
+					OutputCapture capture(&row_output[RESTART_LZ78Y], verbose > 0);
+					row_results[RESTART_LZ78Y] = LZ78Y_test(rdata, len, alph_size, verbose, "Literal");
+				}
+				#pragma omp task
+				{
+					OutputCapture capture(&col_output[RESTART_LZ78Y], verbose > 0);
+					col_results[RESTART_LZ78Y] = LZ78Y_test(cdata, len, alph_size, verbose, "Literal");
+				}
+			}
+		}
+	}
+
+	// Reduce the results in the order that the estimators are listed in SP800-90B
+	if(report) printf("Running Most Common Value Estimate...\n");
+	*H_r = reduce_estimate(*H_r, row_results[RESTART_MCV], row_output[RESTART_MCV], "Most Common Value Estimate (Rows)", word_size, true, verbose);
+	*H_c = reduce_estimate(*H_c, col_results[RESTART_MCV], col_output[RESTART_MCV], "Most Common Value Estimate (Cols)", word_size, true, verbose);
+
+	if(!iid){
+		if(alph_size == 2){
+			if(report) printf("\nRunning Entropic Statistic Estimates (bit strings only)...\n");
+			*H_r = reduce_estimate(*H_r, row_results[RESTART_COLLISION], row_output[RESTART_COLLISION], "Collision Test Estimate (Rows)", 1, true, verbose);
+			*H_c = reduce_estimate(*H_c, col_results[RESTART_COLLISION], col_output[RESTART_COLLISION], "Collision Test Estimate (Cols)", 1, true, verbose);
+			*H_r = reduce_estimate(*H_r, row_results[RESTART_MARKOV], row_output[RESTART_MARKOV], "Markov Test Estimate (Rows)", 1, true, verbose);
+			*H_c = reduce_estimate(*H_c, col_results[RESTART_MARKOV], col_output[RESTART_MARKOV], "Markov Test Estimate (Cols)", 1, true, verbose);
+			*H_r = reduce_estimate(*H_r, row_results[RESTART_COMPRESSION], row_output[RESTART_COMPRESSION], "Compression Test Estimate (Rows)", 1, false, verbose);
+			*H_c = reduce_estimate(*H_c, col_results[RESTART_COMPRESSION], col_output[RESTART_COMPRESSION], "Compression Test Estimate (Cols)", 1, false, verbose);
+		}
+
+		if(report) printf("\nRunning Tuple Estimates...\n");
+		// Each run of SAalgs gives both the t-Tuple and the LRS estimates, so both runs' output comes first
+		fputs(row_output[RESTART_TTUPLE].c_str(), stdout);
+		fputs(col_output[RESTART_TTUPLE].c_str(), stdout);
+		*H_r = reduce_estimate(*H_r, row_results[RESTART_TTUPLE], "", "T-Tuple Test Estimate (Rows)", word_size, true, verbose);
+		*H_c = reduce_estimate(*H_c, col_results[RESTART_TTUPLE], "", "T-Tuple Test Estimate (Cols)", word_size, true, verbose);
+		*H_r = reduce_estimate(*H_r, row_results[RESTART_LRS], row_output[RESTART_LRS], "LRS Test Estimate (Rows)", word_size, true, verbose);
+		*H_c = reduce_estimate(*H_c, col_results[RESTART_LRS], col_output[RESTART_LRS], "LRS Test Estimate (Cols)", word_size, true, verbose);
+
+		if(report) printf("\nRunning Predictor Estimates...\n");
+		*H_r = reduce_estimate(*H_r, row_results[RESTART_MULTI_MCW], row_output[RESTART_MULTI_MCW], "Multi Most Common in Window (MultiMCW) Prediction Test Estimate (Rows)", word_size, false, verbose);
+		*H_c = reduce_estimate(*H_c, col_results[RESTART_MULTI_MCW], col_output[RESTART_MULTI_MCW], "Multi Most Common in Window (MultiMCW) Prediction Test Estimate (Cols)", word_size, false, verbose);
+		*H_r = reduce_estimate(*H_r, row_results[RESTART_LAG], row_output[RESTART_LAG], "Lag Prediction Test Estimate (Rows)", word_size, false, verbose);
+		*H_c = reduce_estimate(*H_c, col_results[RESTART_LAG], col_output[RESTART_LAG], "Lag Prediction Test Estimate (Cols)", word_size, false, verbose);
+		*H_r = reduce_estimate(*H_r, row_results[RESTART_MULTI_MMC], row_output[RESTART_MULTI_MMC], "Multi Markov Model with Counting (MultiMMC) Prediction Test Estimate (Rows)", word_size, false, verbose);
+		*H_c = reduce_estimate(*H_c, col_results[RESTART_MULTI_MMC], col_output[RESTART_MULTI_MMC], "Multi Markov Model with Counting (MultiMMC) Prediction Test Estimate (Cols)", word_size, false, verbose);
+		*H_r = reduce_estimate(*H_r, row_results[RESTART_LZ78Y], row_output[RESTART_LZ78Y], "LZ78Y Prediction Test Estimate (Rows)", word_size, false, verbose);
+		*H_c = reduce_estimate(*H_c, col_results[RESTART_LZ78Y], col_output[RESTART_LZ78Y], "LZ78Y Prediction Test Estimate (Cols)", word_size, false, verbose);
+	}
+}
+
+//The outcome of assessing one restart matrix in batch mode
+#define RESTART_PASSED 0
+#define RESTART_SANITY_FAILED 1
+#define RESTART_VALIDATION_FAILED 2
+#define RESTART_NOT_ASSESSED 3
+
+struct restart_result {
+	int alph_size;
+	long X_cutoff;
+	long X_max;
+	double H_r;
+	double H_c;
+	int status;
+};
+
+//Returns the number of distinct symbols in the data, once each sample is reduced to word_size bits
+int count_symbols(const byte *data, long len, int word_size) {
+	bool present[256];
+	int mask = (1 << word_size) - 1;
+	int alph_size = 0;
+
+	memset(present, 0, sizeof(present));
+	for(long i = 0; i < len; i++) present[data[i] & mask] = true;
+	for(int i = 0; i < 256; i++) if(present[i]) alph_size++;
+
+	return alph_size;
+}
+
+//Runs the sanity check and validation test on a single restart matrix, without printing anything
+void restart_matrix(const byte *matrix, int word_size, double H_I, bool iid, const map<int, long> &cutoffs, struct restart_result *result) {
+	const int r = 1000, c = 1000;
+	data_t data;
+	byte *cdata;
+
+	result->status = RESTART_NOT_ASSESSED;
+	result->X_cutoff = -1;
+	result->X_max = -1;
+	result->H_r = -1.0;
+	result->H_c = -1.0;
+
+	data.word_size = word_size;
+	if(!read_buffer(matrix, MIN_SIZE, &data)) return;
+
+	result->alph_size = data.alph_size;
+	//Matrices without a cutoff (too few symbols for H_I) aren't assessed
+	if((data.alph_size <= 1) || (cutoffs.find(data.alph_size) == cutoffs.end())) {
+		free_data(&data);
+		return;
+	}
+
+	cdata = (byte*)malloc(data.len);
+	if(cdata == NULL){
+		printf("Error: failure to initialize memory for columns\n");
+		free_data(&data);
+		return;
+	}
+
+	// perform sanity check on rows and columns of restart data (Section 3.1.4.3)
+	transpose_matrix(data.symbols, cdata, r, c);
+	result->X_cutoff = cutoffs.at(data.alph_size);
+	result->X_max = max(max_row_count(data.symbols, r, c), max_row_count(cdata, c, r));
+
+	if(result->X_max > result->X_cutoff) {
+		result->status = RESTART_SANITY_FAILED;
+	} else {
+		result->H_r = data.word_size;
+		result->H_c = data.word_size;
+		restart_estimates(data.symbols, cdata, data.len, data.alph_size, data.word_size, iid, 0, false, &result->H_r, &result->H_c);
+
+		if(min(result->H_r, result->H_c) < H_I/2.0) result->status = RESTART_VALIDATION_FAILED;
+		else result->status = RESTART_PASSED;
+	}
+
+	free(cdata);
+	free_data(&data);
+}
+
+//Assesses every complete 1000x1000 restart matrix in the file, and prints one summary line per matrix.
+//Returns 0 if every matrix passes the sanity check, and -1 otherwise.
+int restart_batch(const char *file_path, int word_size, double H_I, bool iid, bool analytic, const char *cache_path, int cache_precision, bool regenerate, int verbose) {
+	const int r = 1000, c = 1000;
+	const byte *buffer;
+	long file_len, matrix_count;
+	double alpha;
+	vector<int> alph_sizes;
+	vector<struct restart_result> results;
+	map<int, long> cutoffs;
+	set<int> skipped;
+	int ret = 0;
+
+	if(verbose > 0) printf("Opening file: '%s'\n", file_path);
+
+	if(!map_file(file_path, &buffer, &file_len)){
+		printf("Error reading file.\n");
+		return -1;
+	}
+
+	matrix_count = file_len / MIN_SIZE;
+	if(matrix_count == 0){
+		printf("\n*** Error: data does not contain %d samples ***\n\n", MIN_SIZE);
+		unmap_file(buffer, file_len);
+		return -1;
+	}
+
+	if((file_len % MIN_SIZE) != 0) printf("Warning: Ignoring the last %ld samples, which don't make up a complete restart matrix.\n", file_len % MIN_SIZE);
+
+	// All the matrices in a capture share a word size
+	if(word_size == 0) word_size = symbol_bit_width(buffer, matrix_count * MIN_SIZE);
+
+	if(H_I > word_size) {
+		printf("H_I must be at most 'bits_per_symbol'.\n");
+		unmap_file(buffer, file_len);
+		return -1;
+	}
+
+	if(verbose > 0) printf("Found %ld restart matrices of %d-bit-wide symbols.\n", matrix_count, word_size);
+	profile_set_input(matrix_count * MIN_SIZE, word_size);
+
+	printf("H_I: %f\n", H_I);
+	alpha = 1 - exp(log(0.99)/(r + c));
+
+	// The cutoff depends on the alphabet size of each matrix. Each distinct cutoff is found once (the simulation is itself parallel).
+	alph_sizes.resize(matrix_count);
+	#pragma omp parallel for
+	for(long m = 0; m < matrix_count; m++) alph_sizes[m] = count_symbols(buffer + m*MIN_SIZE, MIN_SIZE, word_size);
+
+	for(long m = 0; m < matrix_count; m++) {
+		int k = alph_sizes[m];
+
+		if((k <= 1) || (cutoffs.find(k) != cutoffs.end()) || (skipped.find(k) != skipped.end())) continue;
+
+		//With fewer than 2^H_I symbols, the matrix can't have H_I bits of min-entropy, so it isn't assessed
+		if(!cutoff_defined(k, H_I)) {
+			printf("k: %d, no cutoff, as %d symbols can't have H_I bits of min-entropy\n", k, k);
+			skipped.insert(k);
+			continue;
+		}
+
+		{
+			ProfileScope profile("sanity_cutoff", NULL, 0, true);
+			if(analytic) cutoffs[k] = analyticBound(alpha, k, H_I);
+			else cutoffs[k] = cachedBound(alpha, k, H_I, cache_path, cache_precision, regenerate, verbose);
+		}
+		printf("ALPHA: %.17g, k: %d, X_cutoff: %ld\n", alpha, k, cutoffs[k]);
+	}
+
+	results.resize(matrix_count);
+	#pragma omp parallel for schedule(dynamic)
+	for(long m = 0; m < matrix_count; m++) {
+		restart_matrix(buffer + m*MIN_SIZE, word_size, H_I, iid, cutoffs, &results[m]);
+	}
+
+	printf("\n");
+	for(long m = 0; m < matrix_count; m++) {
+		struct restart_result *result = &results[m];
+
+		switch(result->status) {
+			case RESTART_PASSED:
+				printf("Matrix %ld: X_max = %ld, X_cutoff = %ld, H_r = %f, H_c = %f, Validation Test Passed, min(H_r, H_c, H_I) = %f\n",
+					m, result->X_max, result->X_cutoff, result->H_r, result->H_c, min(min(result->H_r, result->H_c), H_I));
+				break;
+			case RESTART_VALIDATION_FAILED:
+				printf("Matrix %ld: X_max = %ld, X_cutoff = %ld, H_r = %f, H_c = %f, Validation Testing Failed\n",
+					m, result->X_max, result->X_cutoff, result->H_r, result->H_c);
+				break;
+			case RESTART_SANITY_FAILED:
+				printf("Matrix %ld: X_max = %ld, X_cutoff = %ld, Restart Sanity Check Failed\n", m, result->X_max, result->X_cutoff);
+				ret = -1;
+				break;
+			default:
+				printf("Matrix %ld: Not assessed\n", m);
+				ret = -1;
+				break;
+		}
+	}
+
+	unmap_file(buffer, file_len);
+	return ret;
 }
 
 int main(int argc, char* argv[]){
-	bool iid;
+	bool iid, analytic, regenerate, batch;
 	int verbose = 0;
+	char *cache_path;
+	int cache_precision;
 	char *file_path;
 	int r = 1000, c = 1000;
-	int counts[256];
 	long int X_cutoff;
-	long i, j, X_i, X_r, X_c, X_max;
-	double H_I, H_r, H_c, alpha, ret_min_entropy; 
+	long X_r, X_c, X_max;
+	double H_I, H_r, H_c, alpha;
 	byte *rdata, *cdata;
 	data_t data;
+	const char *profile_path = NULL;
+	bool loaded;
 	int opt;
+	//The long options only; their values are outside the range of the short options' characters
+	static const struct option long_options[] = {
+		{"profile", required_argument, NULL, 256},
+		{NULL, 0, NULL, 0}
+	};
 
 	iid = false;
+	analytic = false;
+	regenerate = false;
+	batch = false;
+	cache_path = NULL;
+	cache_precision = DEFAULT_CACHE_PRECISION;
 	data.word_size = 0;
 
-        while ((opt = getopt(argc, argv, "inv")) != -1) {
+        while ((opt = getopt_long(argc, argv, "inavbc:gp:", long_options, NULL)) != -1) {
                 switch(opt) {
+                        case 'b':
+                                batch = true;
+                                break;
+                        case 'c':
+                                cache_path = optarg;
+                                break;
+                        case 'g':
+                                regenerate = true;
+                                break;
+                        case 'p':
+                                cache_precision = atoi(optarg);
+                                if((cache_precision < 0) || (cache_precision > 15)) {
+                                        printf("Precision must be between 0 and 15.\n");
+                                        print_usage();
+                                }
+                                break;
+                        case 'a':
+                                analytic = true;
+                                break;
                         case 'i':
                                 iid = true;
                                 break;
@@ -148,6 +833,9 @@ int main(int argc, char* argv[]){
                         case 'v':
                                 verbose++;
                                 break;
+                        case 256:
+                                profile_path = optarg;
+                                break;
                         default:
                                 print_usage();
                 }
@@ -186,12 +874,21 @@ int main(int argc, char* argv[]){
 		print_usage();
 	}
 
+	if(!profile_init("ea_restart", file_path, profile_path)) exit(-1);
+
+	if(batch) return restart_batch(file_path, data.word_size, H_I, iid, analytic, cache_path, cache_precision, regenerate, verbose);
+
 	if(verbose > 0) printf("Opening file: '%s'\n", file_path);
 
-	if(!read_file(file_path, &data)){
+	{
+		ProfileScope profile("read_file", NULL, 0);
+		loaded = read_file(file_path, &data);
+	}
+	if(!loaded){
 		printf("Error reading file.\n");
 		print_usage();
 	}
+	profile_set_input(data.len, data.word_size);
 	if(verbose > 0) printf("Loaded %ld samples made up of %d distinct %d-bit-wide symbols.\n", data.len, data.alph_size, data.word_size);
 
 	if(H_I > data.word_size) {
@@ -210,6 +907,12 @@ int main(int argc, char* argv[]){
 		printf("\n*** Error: data does not contain %d samples ***\n\n", MIN_SIZE);
 		exit(-1);
 	}
+
+	if(!cutoff_defined(data.alph_size, H_I)) {
+		printf("H_I must be at most log2 of the number of distinct symbols (%d), or the sanity check has no cutoff.\n", data.alph_size);
+		free_data(&data);
+		exit(-1);
+	}
 	if(verbose > 0) {
 		if(data.alph_size < (1 << data.word_size)) printf("\nSymbols have been translated.\n\n");
 	}
@@ -224,35 +927,19 @@ int main(int argc, char* argv[]){
 	printf("H_I: %f\n", H_I);
 
 	alpha = 1 - exp(log(0.99)/(r + c));
-	X_cutoff = simulateBound(alpha, data.alph_size, H_I);
+	{
+		ProfileScope profile("sanity_cutoff", NULL, 0, true);
+		if(analytic) X_cutoff = analyticBound(alpha, data.alph_size, H_I);
+		else X_cutoff = cachedBound(alpha, data.alph_size, H_I, cache_path, cache_precision, regenerate, verbose);
+	}
 	printf("ALPHA: %.17g, X_cutoff: %ld\n", alpha, X_cutoff);
 
 	// get maximum row count
-	X_r = 0;
-	for(i = 0; i < r; i++){ //row
-		memset(counts, 0, 256*sizeof(int));
-		X_i = 0;
-		for(j = 0; j < c; j++){//column
-			//[i*r+j] is row i, column j
-			//So, we're fixing a row, and then iterate through various columns
-			if(++counts[rdata[i*r+j]] > X_i) X_i = counts[rdata[i*r+j]];
-		}
-		if(X_i > X_r) X_r = X_i;
-	}
+	X_r = max_row_count(rdata, r, c);
 
 	// construct column data from row data and get maximum column count
-	X_c = 0;
-	for(j = 0; j < c; j++){ //columns
-		memset(counts, 0, 256*sizeof(int));
-		X_i = 0;
-		for(i = 0; i < r; i++){
-			//[i*r+j] is row i, column j
-			//So, we're fixing a column and iterating through various rows
-			cdata[j*c+i] = rdata[i*r+j];
-			if(++counts[cdata[j*c+i]] > X_i) X_i = counts[cdata[j*c+i]];
-		}
-		if(X_i > X_c) X_c = X_i;
-	}
+	transpose_matrix(rdata, cdata, r, c);
+	X_c = max_row_count(cdata, c, r);
 
 	// perform sanity check on rows and columns of restart data (Section 3.1.4.3)
 	X_max = max(X_r, X_c);
@@ -267,122 +954,7 @@ int main(int argc, char* argv[]){
 	H_c = data.word_size;
 	H_r = data.word_size;
 
-	if(iid)	printf("\nRunning IID tests...\n\n");
-	else printf("\nRunning non-IID tests...\n\n");
-
-	printf("Running Most Common Value Estimate...\n");
-
-	// Section 6.3.1 - Estimate entropy with Most Common Value
-	ret_min_entropy = most_common(rdata, data.len, data.alph_size, verbose, "Literal");
-	if(verbose > 0) printf("\tMost Common Value Estimate (Rows) = %f / %d bit(s)\n", ret_min_entropy, data.word_size);
-	H_r = min(ret_min_entropy, H_r);
-	ret_min_entropy = most_common(cdata, data.len, data.alph_size, verbose, "Literal");
-	if(verbose > 0) printf("\tMost Common Value Estimate (Cols) = %f / %d bit(s)\n", ret_min_entropy, data.word_size);
-	H_c = min(ret_min_entropy, H_c);
-
-	if(!iid){
-		if(data.alph_size == 2){
-			printf("\nRunning Entropic Statistic Estimates (bit strings only)...\n");
-
-			// Section 6.3.2 - Estimate entropy with Collision Test (for bit strings only)
-			ret_min_entropy = collision_test(rdata, data.len, verbose, "Literal");
-			if(verbose > 0) printf("\tCollision Test Estimate (Rows) = %f / 1 bit(s)\n", ret_min_entropy); 
-			H_r = min(ret_min_entropy, H_r);
-			ret_min_entropy = collision_test(cdata, data.len, verbose, "Literal");
-			if(verbose > 0) printf("\tCollision Test Estimate (Cols) = %f / 1 bit(s)\n", ret_min_entropy); 
-			H_c = min(ret_min_entropy, H_c);
-
-			// Section 6.3.3 - Estimate entropy with Markov Test (for bit strings only)
-			ret_min_entropy = markov_test(rdata, data.len, verbose, "Literal");
-			if(verbose > 0) printf("\tMarkov Test Estimate (Rows) = %f / 1 bit(s)\n", ret_min_entropy); 
-			H_r = min(ret_min_entropy, H_r);
-			ret_min_entropy = markov_test(cdata, data.len, verbose, "Literal");
-			if(verbose > 0) printf("\tMarkov Test Estimate (Cols) = %f / 1 bit(s)\n", ret_min_entropy); 
-			H_c = min(ret_min_entropy, H_c);
-
-			// Section 6.3.4 - Estimate entropy with Compression Test (for bit strings only)
-			ret_min_entropy = compression_test(rdata, data.len, verbose, "Literal");
-			if(ret_min_entropy >= 0){
-				if(verbose > 0) printf("\tCompression Test Estimate (Rows) = %f / 1 bit(s)\n", ret_min_entropy); 
-				H_r = min(ret_min_entropy, H_r);
-			}
-			ret_min_entropy = compression_test(cdata, data.len, verbose, "Literal");
-			if(ret_min_entropy >= 0){
-				if(verbose > 0) printf("\tCompression Test Estimate (Cols) = %f / 1 bit(s)\n", ret_min_entropy); 
-				H_c = min(ret_min_entropy, H_c);
-			}
-		}
-
-		printf("\nRunning Tuple Estimates...\n");
-
-		// Section 6.3.5 - Estimate entropy with t-Tuple Test
-		double row_t_tuple_res, row_lrs_res;
-		double col_t_tuple_res, col_lrs_res;
-		SAalgs(rdata, data.len, data.alph_size, row_t_tuple_res, row_lrs_res, verbose, "Literal");
-		SAalgs(cdata, data.len, data.alph_size, col_t_tuple_res, col_lrs_res, verbose, "Literal");
-
-		if(verbose > 0) printf("\tT-Tuple Test Estimate (Rows) = %f / %d bit(s)\n", row_t_tuple_res, data.word_size);
-		H_r = min(row_t_tuple_res, H_r);
-
-		if(verbose > 0) printf("\tT-Tuple Test Estimate (Cols) = %f / %d bit(s)\n", col_t_tuple_res, data.word_size);
-		H_c = min(col_t_tuple_res, H_c);
-
-		// Section 6.3.6 - Estimate entropy with LRS Test
-		if(verbose > 0) printf("\tLRS Test Estimate (Rows) = %f / %d bit(s)\n", row_lrs_res, data.word_size);
-		H_r = min(row_lrs_res, H_r);
-		if(verbose > 0) printf("\tLRS Test Estimate (Cols) = %f / %d bit(s)\n", col_lrs_res, data.word_size);
-		H_c = min(col_lrs_res, H_c);
-
-		printf("\nRunning Predictor Estimates...\n");
-
-		// Section 6.3.7 - Estimate entropy with Multi Most Common in Window Test
-		ret_min_entropy = multi_mcw_test(rdata, data.len, data.alph_size, verbose, "Literal");
-		if(ret_min_entropy >= 0){
-			if(verbose > 0) printf("\tMulti Most Common in Window (MultiMCW) Prediction Test Estimate (Rows) = %f / %d bit(s)\n", ret_min_entropy, data.word_size);
-			H_r = min(ret_min_entropy, H_r);
-		}
-		ret_min_entropy = multi_mcw_test(cdata, data.len, data.alph_size, verbose, "Literal");
-		if(ret_min_entropy >= 0){
-			if(verbose > 0) printf("\tMulti Most Common in Window (MultiMCW) Prediction Test Estimate (Cols) = %f / %d bit(s)\n", ret_min_entropy, data.word_size);
-			H_c = min(ret_min_entropy, H_c);
-		}
-
-		// Section 6.3.8 - Estimate entropy with Lag Prediction Test
-		ret_min_entropy = lag_test(rdata, data.len, data.alph_size, verbose, "Literal");
-		if(ret_min_entropy >= 0){
-			if(verbose > 0) printf("\tLag Prediction Test Estimate (Rows) = %f / %d bit(s)\n", ret_min_entropy, data.word_size);
-			H_r = min(ret_min_entropy, H_r);
-		}
-		ret_min_entropy = lag_test(cdata, data.len, data.alph_size, verbose, "Literal");
-		if(ret_min_entropy >= 0){
-			if(verbose > 0) printf("\tLag Prediction Test Estimate (Cols) = %f / %d bit(s)\n", ret_min_entropy, data.word_size);
-			H_c = min(ret_min_entropy, H_c);
-		}
-
-		// Section 6.3.9 - Estimate entropy with Multi Markov Model with Counting Test (MultiMMC)
-		ret_min_entropy = multi_mmc_test(rdata, data.len, data.alph_size, verbose, "Literal");
-		if(ret_min_entropy >= 0){
-			if(verbose > 0) printf("\tMulti Markov Model with Counting (MultiMMC) Prediction Test Estimate (Rows) = %f / %d bit(s)\n", ret_min_entropy, data.word_size);
-			H_r = min(ret_min_entropy, H_r);
-		}
-		ret_min_entropy = multi_mmc_test(cdata, data.len, data.alph_size, verbose, "Literal");
-		if(ret_min_entropy >= 0){
-			if(verbose > 0) printf("\tMulti Markov Model with Counting (MultiMMC) Prediction Test Estimate (Cols) = %f / %d bit(s)\n", ret_min_entropy, data.word_size);
-			H_c = min(ret_min_entropy, H_c);
-		}
-
-		// Section 6.3.10 - Estimate entropy with LZ78Y Test
-		ret_min_entropy = LZ78Y_test(rdata, data.len, data.alph_size, verbose, "Literal");
-		if(ret_min_entropy >= 0){
-			if(verbose > 0) printf("\tLZ78Y Prediction Test Estimate (Rows) = %f / %d bit(s)\n", ret_min_entropy, data.word_size);
-			H_r = min(ret_min_entropy, H_r);
-		}
-		ret_min_entropy = LZ78Y_test(cdata, data.len, data.alph_size, verbose, "Literal");
-		if(ret_min_entropy >= 0){
-			if(verbose > 0) printf("\tLZ78Y Prediction Test Estimate (Cols) = %f / %d bit(s)\n", ret_min_entropy, data.word_size);
-			H_c = min(ret_min_entropy, H_c);
-		}
-	}
+	restart_estimates(rdata, cdata, data.len, data.alph_size, data.word_size, iid, verbose, true, &H_r, &H_c);
 
 	printf("\n");
 	printf("H_r: %f\n", H_r);
@@ -0,0 +1,79 @@
+#include "arena.h"
+
+static void arena_allocate_block(struct arena *a, size_t size) {
+	void *block = NULL;
+
+	a->size = arena_round(size);
+	if((a->size > 0) && (posix_memalign(&block, ARENA_ALIGN, a->size) != 0)) throw bad_alloc();
+	a->base = (byte *)block;
+}
+
+void arena_init(struct arena *a, size_t size) {
+	a->used = 0;
+	a->peak = 0;
+	a->overflow_bytes = 0;
+	a->overflow.clear();
+	arena_allocate_block(a, size);
+}
+
+void arena_reserve(struct arena *a, size_t size) {
+	if((a->used == 0) && a->overflow.empty() && (arena_round(size) > a->size)) {
+		free(a->base);
+		arena_allocate_block(a, size);
+	}
+}
+
+void *arena_alloc(struct arena *a, size_t bytes) {
+	size_t start = arena_round(a->used);
+	void *p;
+
+	if(start + bytes <= a->size) {
+		a->used = start + bytes;
+		p = a->base + start;
+	} else {
+		p = malloc(bytes);
+		if(p == NULL) throw bad_alloc();
+		a->overflow.push_back(p);
+		a->overflow_bytes += arena_round(bytes);
+	}
+
+	a->peak = max(a->peak, arena_round(a->used) + a->overflow_bytes);
+
+	return p;
+}
+
+struct arena_mark arena_get_mark(const struct arena *a) {
+	struct arena_mark mark;
+
+	mark.used = a->used;
+	mark.overflow = a->overflow.size();
+	mark.overflow_bytes = a->overflow_bytes;
+
+	return mark;
+}
+
+void arena_rewind(struct arena *a, struct arena_mark mark) {
+	for(size_t i = mark.overflow; i < a->overflow.size(); i++) free(a->overflow[i]);
+	a->overflow.resize(mark.overflow);
+	a->overflow_bytes = mark.overflow_bytes;
+	a->used = mark.used;
+}
+
+void arena_reset(struct arena *a) {
+	struct arena_mark start = {0, 0, 0};
+
+	arena_rewind(a, start);
+	if(a->peak > a->size) {
+		free(a->base);
+		arena_allocate_block(a, a->peak);
+	}
+}
+
+void arena_free(struct arena *a) {
+	struct arena_mark start = {0, 0, 0};
+
+	arena_rewind(a, start);
+	free(a->base);
+	a->base = NULL;
+	a->size = 0;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "utils.h"
+#include <new>			// std::bad_alloc
+
+//Arena allocations are aligned to a cache line
+#define ARENA_ALIGN 64
+
+//A bump allocator for scratch memory. Memory is handed out from one block and is only released all at
+//once, by rewinding to an earlier mark, so work that is repeated many times (such as the tests run for each
+//permutation) reuses the same memory rather than returning to malloc each time.
+//If the block runs out, allocations fall back to malloc until the arena is reset; at that point the block
+//is grown to the most memory that was in use, so an undersized arena only overflows once.
+//An arena must only be used by one thread at a time.
+struct arena {
+	byte *base;
+	size_t size;
+	size_t used;
+	size_t peak;		// the most memory in use at once, including the fallback allocations
+	size_t overflow_bytes;	// the memory in the fallback allocations
+	vector<void *> overflow;
+};
+
+struct arena_mark {
+	size_t used;
+	size_t overflow;
+	size_t overflow_bytes;
+};
+
+static inline size_t arena_round(size_t bytes) {
+	return (bytes + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1);
+}
+
+void arena_init(struct arena *a, size_t size);
+
+//Makes sure that the arena holds at least size bytes. This only has an effect if nothing is allocated.
+void arena_reserve(struct arena *a, size_t size);
+
+void *arena_alloc(struct arena *a, size_t bytes);
+
+//Allocates uninitialized space for count objects of type T
+template<typename T>
+T *arena_array(struct arena *a, size_t count) {
+	return (T *)arena_alloc(a, count * sizeof(T));
+}
+
+struct arena_mark arena_get_mark(const struct arena *a);
+
+//Releases everything allocated since the mark was taken
+void arena_rewind(struct arena *a, struct arena_mark mark);
+
+//Releases everything, growing the block if it was too small for the work done since the last reset
+void arena_reset(struct arena *a);
+
+void arena_free(struct arena *a);
+
+//The scratch memory used by the binary dictionaries of the MultiMMC and LZ78Y predictors, which
+//have one table of 2^(j+2) counts for each prefix length j+1 up to depth
+static inline size_t binary_dict_scratch_size(int depth) {
+	size_t size = 0;
+
+	for(int j = 0; j < depth; j++) size += arena_round(sizeof(long) << (j+2));
+
+	return size;
+}
+
+//Scratch memory for the duration of one call. The memory comes from the caller's arena, and is released
+//when the scope ends; if the caller doesn't supply an arena, a private one of the given size is used.
+class ScratchScope {
+public:
+	ScratchScope(struct arena *scratch, size_t size) : owned(scratch == NULL) {
+		if(owned) {
+			arena_init(&local, size);
+			a = &local;
+		} else {
+			a = scratch;
+		}
+		mark = arena_get_mark(a);
+	}
+
+	~ScratchScope() {
+		if(owned) arena_free(&local);
+		else if((mark.used == 0) && (mark.overflow == 0)) arena_reset(a);
+		else arena_rewind(a, mark);
+	}
+
+	struct arena *get() { return a; }
+
+private:
+	bool owned;
+	struct arena local;
+	struct arena *a;
+	struct arena_mark mark;
+};
@@ -0,0 +1,39 @@
+#include "cpu_dispatch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static enum cpu_isa_level cpu_isa_detect() {
+	enum cpu_isa_level level = CPU_ISA_BASELINE;
+	const char *cap = getenv("EA_ISA");
+
+#ifdef CPU_DISPATCH
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2")) level = CPU_ISA_AVX2;
+	if((level == CPU_ISA_AVX2) && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) level = CPU_ISA_AVX512;
+#endif
+
+	//EA_ISA limits the kernels to an instruction set, so that each variant can be checked on one host
+	if(cap != NULL) {
+		if(strcmp(cap, "baseline") == 0) level = CPU_ISA_BASELINE;
+		else if(strcmp(cap, "avx2") == 0) { if(level > CPU_ISA_AVX2) level = CPU_ISA_AVX2; }
+		else if(strcmp(cap, "avx512") != 0) fprintf(stderr, "Ignoring EA_ISA=%s (expected baseline, avx2 or avx512)\n", cap);
+	}
+
+	return level;
+}
+
+enum cpu_isa_level cpu_isa() {
+	static const enum cpu_isa_level level = cpu_isa_detect();
+
+	return level;
+}
+
+const char *cpu_isa_name(enum cpu_isa_level level) {
+	switch(level) {
+		case CPU_ISA_AVX512: return "AVX-512";
+		case CPU_ISA_AVX2: return "AVX2";
+		default: return "baseline";
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+//The instruction sets that the hot kernels are compiled for. The tools are built for a portable baseline,
+//and the wider variants of each kernel are compiled with a target attribute and chosen at run time, so
+//one binary runs on every x86-64 host and still uses the widest vectors that the host has.
+enum cpu_isa_level {
+	CPU_ISA_BASELINE = 0,	// SSE2 and POPCNT, which every build assumes
+	CPU_ISA_AVX2 = 1,
+	CPU_ISA_AVX512 = 2	// AVX-512F and AVX-512BW
+};
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && defined(__SSE2__)
+#define CPU_DISPATCH 1
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx2,popcnt")))
+#endif
+
+//The widest kernels that this host can run. This is established once, on first use.
+enum cpu_isa_level cpu_isa();
+
+const char *cpu_isa_name(enum cpu_isa_level level);
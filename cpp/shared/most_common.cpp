@@ -0,0 +1,62 @@
+#include "most_common.h"
+#include "profile.h"
+
+double most_common_from_counts(const long counts[], const long len, const int alph_size, const int verbose, const char *label){
+	long i, mode;
+	double pmax, ubound;
+	double entEst;
+
+	assert(len > 1);
+
+	mode = 0;
+	for(i = 0; i < alph_size; i++){
+		if(counts[i] > mode) mode = counts[i];
+	}
+
+	pmax = mode/(double)len;
+
+	ubound = min(1.0,pmax + ZALPHA*sqrt(pmax*(1.0-pmax)/(len-1.0)));
+	entEst = -log2(ubound);
+	if(verbose == 1) verbose_printf("%s MCV Estimate: mode = %ld, p-hat = %.17g, p_u = %.17g\n", label, mode, pmax, ubound);
+	else if(verbose == 2) {
+		verbose_printf("%s Most Common Value Estimate: Mode count = %ld\n", label, mode);
+		verbose_printf("%s Most Common Value Estimate: p-hat = %.17g\n", label, pmax);
+		verbose_printf("%s Most Common Value Estimate: p_u = %.17g\n", label, ubound);
+		verbose_printf("%s Most Common Value Estimate: min entropy = %.17g\n", label, entEst);
+	}
+
+	return entEst;
+}
+
+double most_common(byte* data, const long len, const int alph_size, const int verbose, const char *label){
+	ProfileScope profile("most_common", label, len);
+	long counts[alph_size];
+	long i;
+
+	for(i = 0; i < alph_size; i++) counts[i] = 0;
+	for (i = 0; i < len; i++) counts[data[i]]++;
+
+	return most_common_from_counts(counts, len, alph_size, verbose, label);
+}
+
+void mcv_counts_init(struct mcv_counts *c, const byte *data, const long len, const int alph_size){
+	assert(alph_size <= 256);
+
+	c->len = len;
+	c->alph_size = alph_size;
+	for(int i = 0; i < 256; i++) c->counts[i] = 0;
+	for(long i = 0; i < len; i++) c->counts[data[i]]++;
+}
+
+void mcv_counts_slide(struct mcv_counts *c, const byte *window, const long stride){
+	assert(stride <= c->len);
+
+	for(long i = 0; i < stride; i++) {
+		c->counts[window[i]]--;
+		c->counts[window[c->len + i]]++;
+	}
+}
+
+double most_common_incremental(const struct mcv_counts *c, const int verbose, const char *label){
+	return most_common_from_counts(c->counts, c->len, c->alph_size, verbose, label);
+}
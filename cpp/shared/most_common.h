@@ -1,35 +1,24 @@
 #pragma once
 #include "../shared/utils.h"
 
-// Section 6.3.1 - Most Common Value Estimate
-double most_common(byte* data, const long len, const int alph_size, const int verbose, const char *label){
-
-	long counts[alph_size];
-	long i, mode;
-	double pmax, ubound;
-	double entEst;
+// Section 6.3.1 - Most Common Value Estimate, from the symbol counts of the data
+double most_common_from_counts(const long counts[], const long len, const int alph_size, const int verbose, const char *label);
 
-	assert(len > 1);
-
-	for(i = 0; i < alph_size; i++) counts[i] = 0;
-	for (i = 0; i < len; i++) counts[data[i]]++;
+// Section 6.3.1 - Most Common Value Estimate
+double most_common(byte* data, const long len, const int alph_size, const int verbose, const char *label);
 
-	mode = 0;
-	for(i = 0; i < alph_size; i++){
-		if(counts[i] > mode) mode = counts[i];
-	}
+// Symbol counts for a window that slides along the data, so that the estimate for each
+// successive window costs O(stride) rather than O(window length).
+struct mcv_counts {
+	long counts[256];
+	long len;
+	int alph_size;
+};
 
-	pmax = mode/(double)len;
+void mcv_counts_init(struct mcv_counts *c, const byte *data, const long len, const int alph_size);
 
-	ubound = min(1.0,pmax + ZALPHA*sqrt(pmax*(1.0-pmax)/(len-1.0)));
-	entEst = -log2(ubound);
-	if(verbose == 1) printf("%s MCV Estimate: mode = %ld, p-hat = %.17g, p_u = %.17g\n", label, mode, pmax, ubound);
-	else if(verbose == 2) {
-		printf("%s Most Common Value Estimate: Mode count = %ld\n", label, mode);
-		printf("%s Most Common Value Estimate: p-hat = %.17g\n", label, pmax);
-		printf("%s Most Common Value Estimate: p_u = %.17g\n", label, ubound);
-		printf("%s Most Common Value Estimate: min entropy = %.17g\n", label, entEst);
-	}
+// window points to the start of the current window, and must be followed by at least stride more samples.
+// Afterward, the counts describe the window starting at window+stride.
+void mcv_counts_slide(struct mcv_counts *c, const byte *window, const long stride);
 
-	return entEst;
-}
+double most_common_incremental(const struct mcv_counts *c, const int verbose, const char *label);
@@ -0,0 +1,214 @@
+#include "profile.h"
+
+#include <sys/resource.h>
+
+bool profile_on = false;
+thread_local long profile_search_steps = 0;
+
+//The totals for one phase and label
+struct profile_phase {
+	string phase;
+	string label;
+	long calls;
+	double wall_ns;
+	double cpu_ns;
+	long peak_rss_kb;
+	long peak_growth_kb;	// the most that the resident memory grew by during one call
+	long symbols;
+	long permutations;
+	long search_steps;
+};
+
+static mutex profile_mutex;
+static vector<struct profile_phase> profile_phases;
+static int profile_open_phases = 0;
+static string profile_path, profile_tool, profile_input;
+static long profile_samples = -1;
+static int profile_word_size = 0;
+static struct timespec profile_wall_start;
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end) {
+	return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+//Reads a memory figure (in kB) from /proc/self/status, such as VmRSS or VmHWM
+static long status_kb(const char *field) {
+	char line[256];
+	size_t field_len = strlen(field);
+	long kb = 0;
+	FILE *status = fopen("/proc/self/status", "r");
+
+	if(status == NULL) return 0;
+	while(fgets(line, sizeof(line), status) != NULL) {
+		if((strncmp(line, field, field_len) == 0) && (line[field_len] == ':')) {
+			kb = atol(line + field_len + 1);
+			break;
+		}
+	}
+	fclose(status);
+
+	return kb;
+}
+
+//Resets VmHWM to the current resident memory, so that it then holds the peak since this call. Where
+//the peak can't be reset (before Linux 4.0), VmHWM is the peak since the process started.
+static bool reset_peak_rss() {
+	int fd = open("/proc/self/clear_refs", O_WRONLY);
+	bool reset;
+
+	if(fd < 0) return false;
+	reset = (write(fd, "5", 1) == 1);
+	close(fd);
+
+	return reset;
+}
+
+static void json_string(FILE *out, const char *s) {
+	fputc('"', out);
+	for(; *s != '\0'; s++) {
+		if((*s == '"') || (*s == '\\')) fprintf(out, "\\%c", *s);
+		else if((unsigned char)*s < 0x20) fprintf(out, "\\u%04x", *s);
+		else fputc(*s, out);
+	}
+	fputc('"', out);
+}
+
+static void profile_write() {
+	struct timespec now;
+	struct rusage usage;
+	FILE *out;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	getrusage(RUSAGE_SELF, &usage);
+
+	if(profile_path == "-") {
+		out = stderr;
+	} else if((out = fopen(profile_path.c_str(), "a")) == NULL) {
+		perror(profile_path.c_str());
+		return;
+	}
+
+	lock_guard<mutex> lock(profile_mutex);
+
+	fprintf(out, "{\"tool\": ");
+	json_string(out, profile_tool.c_str());
+	fprintf(out, ", \"input\": ");
+	json_string(out, profile_input.c_str());
+	if(profile_samples >= 0) fprintf(out, ", \"samples\": %ld, \"word_size\": %d", profile_samples, profile_word_size);
+	fprintf(out, ", \"threads\": %d, \"kernels\": \"%s\", \"wall_ms\": %.3f, \"user_ms\": %.3f, \"system_ms\": %.3f, \"peak_rss_kb\": %ld, \"phases\": [",
+		omp_get_max_threads(), cpu_isa_name(cpu_isa()), elapsed_ns(&profile_wall_start, &now) / 1e6,
+		usage.ru_utime.tv_sec * 1e3 + usage.ru_utime.tv_usec / 1e3, usage.ru_stime.tv_sec * 1e3 + usage.ru_stime.tv_usec / 1e3, usage.ru_maxrss);
+
+	for(size_t i = 0; i < profile_phases.size(); i++) {
+		const struct profile_phase *p = &profile_phases[i];
+
+		fprintf(out, "%s{\"phase\": ", (i > 0) ? ", " : "");
+		json_string(out, p->phase.c_str());
+		if(!p->label.empty()) {
+			fprintf(out, ", \"label\": ");
+			json_string(out, p->label.c_str());
+		}
+		fprintf(out, ", \"calls\": %ld, \"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"peak_rss_kb\": %ld, \"peak_growth_kb\": %ld, \"symbols\": %ld",
+			p->calls, p->wall_ns / 1e6, p->cpu_ns / 1e6, p->peak_rss_kb, p->peak_growth_kb, p->symbols);
+		if(p->permutations > 0) fprintf(out, ", \"permutations\": %ld", p->permutations);
+		if(p->search_steps > 0) fprintf(out, ", \"search_steps\": %ld", p->search_steps);
+		fprintf(out, "}");
+	}
+	fprintf(out, "]}\n");
+
+	if(out != stderr) fclose(out);
+}
+
+bool profile_init(const char *tool, const char *input, const char *path) {
+	FILE *out;
+
+	if(path == NULL) path = getenv("EA_PROFILE");
+	if((path == NULL) || (*path == '\0')) return true;
+
+	//Check now that the record can be written, rather than finding out at the end of the run
+	if(strcmp(path, "-") != 0) {
+		if((out = fopen(path, "a")) == NULL) {
+			perror(path);
+			return false;
+		}
+		fclose(out);
+	}
+
+	profile_path = path;
+	profile_tool = tool;
+	profile_input = (input != NULL) ? input : "";
+	clock_gettime(CLOCK_MONOTONIC, &profile_wall_start);
+	profile_on = true;
+	atexit(profile_write);
+
+	return true;
+}
+
+void profile_set_input(long samples, int word_size) {
+	lock_guard<mutex> lock(profile_mutex);
+
+	profile_samples = samples;
+	profile_word_size = word_size;
+}
+
+void profile_begin(struct profile_start *start, bool parallel) {
+	{
+		lock_guard<mutex> lock(profile_mutex);
+
+		//The peak is only reset when no other phase is running, as that would lose the other phase's peak
+		if(profile_open_phases == 0) reset_peak_rss();
+		profile_open_phases++;
+	}
+
+	start->parallel = parallel;
+	start->rss_kb = status_kb("VmRSS");
+	start->search_steps = profile_search_steps;
+	clock_gettime(parallel ? CLOCK_PROCESS_CPUTIME_ID : CLOCK_THREAD_CPUTIME_ID, &start->cpu);
+	clock_gettime(CLOCK_MONOTONIC, &start->wall);
+}
+
+void profile_end(const struct profile_start *start, const char *phase, const char *label, long symbols, long permutations) {
+	struct timespec wall, cpu;
+	long peak_kb;
+	size_t i;
+
+	clock_gettime(CLOCK_MONOTONIC, &wall);
+	clock_gettime(start->parallel ? CLOCK_PROCESS_CPUTIME_ID : CLOCK_THREAD_CPUTIME_ID, &cpu);
+	peak_kb = status_kb("VmHWM");
+
+	if(label == NULL) label = "";
+
+	lock_guard<mutex> lock(profile_mutex);
+
+	profile_open_phases--;
+
+	for(i = 0; i < profile_phases.size(); i++) {
+		if((profile_phases[i].phase == phase) && (profile_phases[i].label == label)) break;
+	}
+	if(i == profile_phases.size()) {
+		struct profile_phase p;
+
+		p.phase = phase;
+		p.label = label;
+		p.calls = 0;
+		p.wall_ns = 0.0;
+		p.cpu_ns = 0.0;
+		p.peak_rss_kb = 0;
+		p.peak_growth_kb = 0;
+		p.symbols = 0;
+		p.permutations = 0;
+		p.search_steps = 0;
+		profile_phases.push_back(p);
+	}
+
+	struct profile_phase *p = &profile_phases[i];
+
+	p->calls++;
+	p->wall_ns += elapsed_ns(&start->wall, &wall);
+	p->cpu_ns += elapsed_ns(&start->cpu, &cpu);
+	p->peak_rss_kb = max(p->peak_rss_kb, peak_kb);
+	p->peak_growth_kb = max(p->peak_growth_kb, peak_kb - start->rss_kb);
+	p->symbols += symbols;
+	p->permutations += permutations;
+	p->search_steps += profile_search_steps - start->search_steps;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "utils.h"
+
+//Opt-in instrumentation of the assessment tools, enabled with a tool's --profile <file> option or by
+//setting EA_PROFILE to a file name. Each estimator call and each phase of the run is timed, and when the
+//tool exits, one JSON record for the whole run is appended to the file ("-" is standard error). The record
+//has the totals for each phase and label: the number of calls, the wall and CPU time, the peak resident
+//memory, and the work done (symbols, permutations, and steps of the searches for p).
+//When phases overlap (the estimators run as concurrent tasks in restart testing, or several windows are
+//assessed at once), each phase's CPU time is still its own, but its peak memory is that of the process.
+
+//Whether profiling is on. This is set before any phase starts, and not changed afterwards.
+extern bool profile_on;
+
+//The steps taken by the searches for p on this thread (calc_p_local and the compression estimate)
+extern thread_local long profile_search_steps;
+
+//Enables profiling if path is given, or failing that, if EA_PROFILE is set. The record is written at exit.
+//Returns false if the profile file can't be opened.
+bool profile_init(const char *tool, const char *input, const char *path);
+
+//Records the size of the data that the run assessed
+void profile_set_input(long samples, int word_size);
+
+struct profile_start {
+	struct timespec wall;
+	struct timespec cpu;
+	bool parallel;
+	long rss_kb;
+	long search_steps;
+};
+
+void profile_begin(struct profile_start *start, bool parallel);
+void profile_end(const struct profile_start *start, const char *phase, const char *label, long symbols, long permutations);
+
+//Times the enclosing scope as one call of the phase. A phase that runs threads of its own sets parallel,
+//so that the CPU time of the whole process is counted rather than that of the calling thread.
+class ProfileScope {
+public:
+	ProfileScope(const char *phase, const char *label, long symbols, bool parallel = false) : phase(phase), label(label), symbols(symbols), permutations(0) {
+		if(profile_on) profile_begin(&start, parallel);
+	}
+
+	~ProfileScope() {
+		if(profile_on) profile_end(&start, phase, label, symbols, permutations);
+	}
+
+	void add_permutations(long count) { permutations += count; }
+
+private:
+	const char *phase;
+	const char *label;
+	long symbols;
+	long permutations;
+	struct profile_start start;
+};
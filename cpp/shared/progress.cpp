@@ -0,0 +1,191 @@
+#include "progress.h"
+
+#include <netdb.h>		// getaddrinfo
+#include <sys/socket.h>
+#include <sys/un.h>		// sockaddr_un
+#include <signal.h>
+
+static FILE *progress_out = NULL;	// standard output unless progress_configure was called
+static long progress_interval_ms = PROGRESS_INTERVAL_MS;
+static bool progress_configured = false;
+
+static int connect_tcp(const char *address) {
+	struct addrinfo hints, *addresses, *a;
+	const char *port = strrchr(address, ':');
+	string host;
+	int fd = -1;
+
+	if(port == NULL) return -1;
+	host.assign(address, port - address);
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if(getaddrinfo(host.c_str(), port + 1, &hints, &addresses) != 0) return -1;
+
+	for(a = addresses; a != NULL; a = a->ai_next) {
+		fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+		if(fd < 0) continue;
+		if(connect(fd, a->ai_addr, a->ai_addrlen) == 0) break;
+		close(fd);
+		fd = -1;
+	}
+	freeaddrinfo(addresses);
+
+	return fd;
+}
+
+static int connect_unix(const char *path) {
+	struct sockaddr_un address;
+	int fd;
+
+	if(strlen(path) >= sizeof(address.sun_path)) return -1;
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	if((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) return -1;
+	if(connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+bool progress_configure(const char *destination, long interval_ms) {
+	FILE *out;
+	int fd = -1;
+
+	if(strcmp(destination, "-") == 0) {
+		out = stdout;
+	} else if(strncmp(destination, "tcp:", 4) == 0) {
+		if((fd = connect_tcp(destination + 4)) < 0) return false;
+		out = fdopen(fd, "w");
+	} else if(strncmp(destination, "unix:", 5) == 0) {
+		if((fd = connect_unix(destination + 5)) < 0) return false;
+		out = fdopen(fd, "w");
+	} else {
+		out = fopen(destination, "w");
+	}
+
+	if(out == NULL) {
+		if(fd >= 0) close(fd);
+		return false;
+	}
+
+	//Each report is written as soon as it is made
+	if(out != stdout) setvbuf(out, NULL, _IOLBF, 0);
+	//If the listener goes away, the reports fail rather than ending the run
+	if(fd >= 0) signal(SIGPIPE, SIG_IGN);
+
+	progress_out = out;
+	if(interval_ms > 0) progress_interval_ms = interval_ms;
+	progress_configured = true;
+
+	return true;
+}
+
+bool progress_requested() {
+	return progress_configured;
+}
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end) {
+	return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+ProgressReporter::ProgressReporter(const char *task, long total, int resolvable, int threads, bool active) :
+	task(task), total(total), resolvable(resolvable), threads(threads), active(active), stopping(false), slots(threads), last_busy_ns(threads, 0) {
+
+	for(int i = 0; i < threads; i++) {
+		slots[i].done.store(0);
+		slots[i].busy_ns.store(0);
+		slots[i].started_ns.store(0);
+	}
+	resolved.store(0);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	last = start;
+
+	if(active) reporter = thread(&ProgressReporter::run, this);
+}
+
+ProgressReporter::~ProgressReporter() {
+	stop();
+}
+
+void ProgressReporter::stop() {
+	if(!active) return;
+
+	{
+		lock_guard<mutex> lock(stop_mutex);
+		stopping = true;
+	}
+	stop_signal.notify_one();
+	reporter.join();
+
+	report(true);
+	active = false;
+}
+
+void ProgressReporter::run() {
+	unique_lock<mutex> lock(stop_mutex);
+
+	while(!stop_signal.wait_for(lock, chrono::milliseconds(progress_interval_ms), [this]{ return stopping; })) {
+		lock.unlock();
+		report(false);
+		lock.lock();
+	}
+}
+
+//Writes one report: the work done and its rate, the results settled so far, the time left if every item is
+//needed, and the share of the last interval that each thread spent working
+void ProgressReporter::report(bool final) {
+	FILE *out = (progress_out != NULL) ? progress_out : stdout;
+	//On a terminal, each report overwrites the last
+	bool overwrite = (out == stdout) && (isatty(STDOUT_FILENO) == 1);
+	struct timespec now;
+	double elapsed, interval, rate;
+	long done = 0;
+	string line;
+	char field[128];
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed = elapsed_ns(&start, &now);
+	interval = elapsed_ns(&last, &now);
+	last = now;
+
+	for(int i = 0; i < threads; i++) done += slots[i].done.load(memory_order_relaxed);
+	rate = (elapsed > 0.0) ? done / (elapsed / 1e9) : 0.0;
+
+	snprintf(field, sizeof(field), "%s: %ld/%ld (%.1f/s), %d/%d resolved", task, done, total, rate, resolved.load(memory_order_relaxed), resolvable);
+	line = field;
+
+	if(final) {
+		snprintf(field, sizeof(field), ", finished in %.1f s", elapsed / 1e9);
+		line += field;
+	} else {
+		if(rate > 0.0) {
+			long eta = (long)ceil((total - done) / rate);
+			snprintf(field, sizeof(field), ", ETA %ld:%02ld:%02ld", eta / 3600, (eta / 60) % 60, eta % 60);
+			line += field;
+		}
+
+		//The time spent on the items in progress counts too, so that long items don't make the threads look idle
+		line += ", busy";
+		for(int i = 0; i < threads; i++) {
+			long started_ns = slots[i].started_ns.load(memory_order_relaxed);
+			long busy_ns = slots[i].busy_ns.load(memory_order_relaxed);
+
+			if(started_ns != 0) busy_ns += max(0L, now.tv_sec * 1000000000L + now.tv_nsec - started_ns);
+			snprintf(field, sizeof(field), " %.0f%%", (interval > 0.0) ? min(100.0, max(0.0, 100.0 * (busy_ns - last_busy_ns[i]) / interval)) : 0.0);
+			line += field;
+			last_busy_ns[i] = busy_ns;
+		}
+	}
+
+	if(overwrite) fprintf(out, "\r%-100s%s", line.c_str(), final ? "\n" : "");
+	else fprintf(out, "%s\n", line.c_str());
+	fflush(out);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "utils.h"
+
+#include <atomic>		// std::atomic
+#include <thread>		// std::thread
+#include <condition_variable>	// std::condition_variable
+
+//The default time between progress reports, in milliseconds
+#define PROGRESS_INTERVAL_MS 1000
+
+//Sends progress reports to destination rather than standard output, every interval_ms milliseconds (0 for
+//the default). The destination is a file name, "-" for standard output, "tcp:<host>:<port>" or "unix:<path>".
+//Once this is called, the long running tests report their progress even without verbose output.
+//Returns false if the destination can't be opened.
+bool progress_configure(const char *destination, long interval_ms);
+
+//Whether progress_configure was called
+bool progress_requested();
+
+//One worker thread's counters. Each is written by its own thread only, and the slots are spaced so that no
+//two threads' counters share a cache line.
+struct progress_slot {
+	atomic<long> done;
+	atomic<long> busy_ns;		// the time spent on the finished work items
+	atomic<long> started_ns;	// when the current work item was started, or 0 if the thread is idle
+	char padding[128 - 3*sizeof(atomic<long>)];
+};
+
+//The monotonic clock, in nanoseconds
+static inline long progress_clock_ns() {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+//Reports the progress of a parallel loop. The workers only update their own atomic counters; a separate
+//thread samples the counters at a fixed interval and writes the reports, so reporting doesn't slow the
+//workers down or make them wait on each other.
+class ProgressReporter {
+public:
+	//total is the number of work items, and resolvable the number of results that can be settled early.
+	//The reporter only runs a thread, and prints, if active.
+	ProgressReporter(const char *task, long total, int resolvable, int threads, bool active);
+	~ProgressReporter();
+
+	//Records that the calling worker started working on an item
+	void started(int thread) {
+		slots[thread].started_ns.store(progress_clock_ns(), memory_order_relaxed);
+	}
+
+	//Records that the calling worker finished an item (which it may have skipped without starting it)
+	void finished(int thread) {
+		struct progress_slot *slot = &slots[thread];
+		long started_ns = slot->started_ns.load(memory_order_relaxed);
+
+		if(started_ns != 0) {
+			slot->busy_ns.store(slot->busy_ns.load(memory_order_relaxed) + (progress_clock_ns() - started_ns), memory_order_relaxed);
+			slot->started_ns.store(0, memory_order_relaxed);
+		}
+		slot->done.store(slot->done.load(memory_order_relaxed) + 1, memory_order_relaxed);
+	}
+
+	void set_resolved(int count) { resolved.store(count, memory_order_relaxed); }
+
+	//Stops the reporting thread and writes the final report
+	void stop();
+
+private:
+	void run();
+	void report(bool final);
+
+	const char *task;
+	long total;
+	int resolvable;
+	int threads;
+	bool active;
+	bool stopping;
+	vector<struct progress_slot> slots;
+	atomic<int> resolved;
+	struct timespec start;
+	struct timespec last;
+	vector<long> last_busy_ns;
+	mutex stop_mutex;
+	condition_variable stop_signal;
+	thread reporter;
+};
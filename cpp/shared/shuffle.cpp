@@ -0,0 +1,64 @@
+#include "shuffle.h"
+
+void FYshuffle(byte data[], const long sample_size, struct random_stream *rs) {
+	long int r;
+
+	for (long int i = sample_size - 1; i > 0; --i) {
+		r = (long int)randomRange64((uint64_t)i, rs);
+		SWAP(data[r], data[i]);
+	}
+}
+
+void bucket_shuffle(byte data[], const long sample_size, struct random_stream *rs, struct arena *scratch) {
+	long start[257];
+	long next[256];
+	int bits = 1;
+	long buckets;
+	struct random_stream replay;
+
+	if(sample_size < SHUFFLE_BUCKETED_MIN) {
+		FYshuffle(data, sample_size, rs);
+		return;
+	}
+
+	ScratchScope scope(scratch, shuffle_scratch_size(sample_size));
+	byte *shuffled = arena_array<byte>(scope.get(), sample_size);
+
+	//Up to 256 buckets, so that each bucket index is one byte of a variate
+	while((bits < 8) && ((SHUFFLE_BUCKET_LEN << bits) < sample_size)) bits++;
+	buckets = 1L << bits;
+
+	//The bucket indices are drawn twice, once to size the buckets and once to fill them, rather than
+	//being stored; replay is the stream as it was before the first draw.
+	memcpy(&replay, rs, sizeof(replay));
+
+	memset(start, 0, sizeof(start));
+	for(long i = 0; i < sample_size; i += 8) {
+		uint64_t x = random_stream_next(rs);
+
+		for(long j = i; j < min(i + 8, sample_size); j++) {
+			start[(x & (buckets - 1)) + 1]++;
+			x >>= 8;
+		}
+	}
+
+	for(long b = 0; b < buckets; b++) {
+		start[b + 1] += start[b];
+		next[b] = start[b];
+	}
+
+	for(long i = 0; i < sample_size; i += 8) {
+		uint64_t x = random_stream_next(&replay);
+
+		for(long j = i; j < min(i + 8, sample_size); j++) {
+			shuffled[next[x & (buckets - 1)]++] = data[j];
+			x >>= 8;
+		}
+	}
+
+	//Each bucket is copied back while it is still in cache
+	for(long b = 0; b < buckets; b++) {
+		FYshuffle(shuffled + start[b], start[b + 1] - start[b], rs);
+		memcpy(data + start[b], shuffled + start[b], start[b + 1] - start[b]);
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "utils.h"
+#include "arena.h"
+
+//Inputs of at least SHUFFLE_BUCKETED_MIN samples are shuffled in buckets of about SHUFFLE_BUCKET_LEN
+//samples, which fit within the per-core caches, rather than by swaps across the whole input. Smaller
+//inputs (of which each thread has its own copy) are expected to stay within the last level cache,
+//where plain Fisher-Yates is faster.
+#define SHUFFLE_BUCKETED_MIN (1L << 22)
+#define SHUFFLE_BUCKET_LEN (1L << 18)
+
+// Fisher-Yates Fast (in place) shuffle algorithm
+void FYshuffle(byte data[], const long sample_size, struct random_stream *rs);
+
+//The scratch memory used by bucket_shuffle
+static inline size_t shuffle_scratch_size(const long sample_size) {
+	return (sample_size >= SHUFFLE_BUCKETED_MIN) ? arena_round(sample_size) : 0;
+}
+
+//A uniformly random permutation of data, by Rao and Sandelius' method: each sample is sent to one of
+//2^bits buckets, chosen uniformly and independently, and then each bucket is shuffled with Fisher-Yates.
+//The concatenation of the shuffled buckets is a uniformly random permutation of the input.
+//The passes over the input are sequential, and every swap falls within a bucket that fits in cache,
+//so large inputs don't spend their time waiting on DRAM.
+void bucket_shuffle(byte data[], const long sample_size, struct random_stream *rs, struct arena *scratch);
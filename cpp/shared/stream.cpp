@@ -0,0 +1,211 @@
+#include "stream.h"
+
+bool stream_read(FILE *in, byte *buffer, long len, bool follow) {
+	long got = 0;
+	size_t rc;
+
+	while(got < len) {
+		rc = fread(buffer + got, sizeof(byte), len - got, in);
+		got += rc;
+
+		if(got < len) {
+			if(ferror(in) || !follow) return false;
+			clearerr(in);
+			usleep(STREAM_POLL_USEC);
+		}
+	}
+
+	return true;
+}
+
+bool stream_skip(FILE *in, long len, bool follow) {
+	byte discard[4096];
+
+	while(len > 0) {
+		long chunk = min(len, (long)sizeof(discard));
+		if(!stream_read(in, discard, chunk, follow)) return false;
+		len -= chunk;
+	}
+
+	return true;
+}
+
+void stream_emit(struct stream_output *output, long position, const char *record) {
+	lock_guard<mutex> lock(output->output_mutex);
+	output->pending[position] = record;
+
+	while(!output->pending.empty() && (output->pending.begin()->first == output->next_index)) {
+		printf("%s\n", output->pending.begin()->second.c_str());
+		output->pending.erase(output->pending.begin());
+		output->next_index++;
+	}
+	fflush(stdout);
+}
+
+void stream_worker(WindowQueue *queue, struct stream_output *output, window_assessor assess, void *context) {
+	struct stream_window *window;
+	char record[STREAM_RECORD_MAX];
+
+	while((window = queue->pop()) != NULL) {
+		record[0] = '\0';
+		assess(window, context, record, sizeof(record));
+
+		stream_emit(output, window->index, record);
+		delete window;
+	}
+}
+
+long stream_assessment(const char *file_path, long window_len, long stride, bool follow, int worker_count, size_t queue_depth, window_assessor assess, void *context) {
+	FILE *in;
+	WindowQueue queue(queue_depth);
+	struct stream_output output;
+	vector<thread> workers;
+	vector<byte> current(window_len);
+	long index, offset;
+
+	assert((window_len > 0) && (stride > 0) && (worker_count > 0) && (queue_depth > 0));
+
+	if(strcmp(file_path, "-") == 0) in = stdin;
+	else in = fopen(file_path, "rb");
+
+	if(in == NULL) {
+		printf("Error: could not open '%s'\n", file_path);
+		return -1;
+	}
+
+	output.next_index = 0;
+	for(int i = 0; i < worker_count; i++) workers.push_back(thread(stream_worker, &queue, &output, assess, context));
+
+	index = 0;
+	offset = 0;
+	if(stream_read(in, current.data(), window_len, follow)) {
+		for(;;) {
+			struct stream_window *window = new struct stream_window;
+
+			window->index = index;
+			window->offset = offset;
+			window->samples = current;
+			queue.push(window);
+
+			index++;
+			offset += stride;
+
+			//Move on to the next window, reusing any overlap with this one
+			if(stride < window_len) {
+				memmove(current.data(), current.data() + stride, window_len - stride);
+				if(!stream_read(in, current.data() + window_len - stride, stride, follow)) break;
+			} else {
+				if(!stream_skip(in, stride - window_len, follow)) break;
+				if(!stream_read(in, current.data(), window_len, follow)) break;
+			}
+		}
+	}
+
+	queue.close();
+	for(size_t i = 0; i < workers.size(); i++) workers[i].join();
+
+	if(in != stdin) fclose(in);
+
+	return index;
+}
+
+long stream_monitor(const char *file_path, long window_len, long stride, bool follow, window_monitor monitor, void *context) {
+	FILE *in;
+	//The window slides along a buffer about twice its length, so it only has to be moved back to the start of
+	//the buffer once every window_len samples, rather than at every step
+	vector<byte> buffer(2*window_len + stride);
+	long index, start;
+
+	assert((window_len > 0) && (stride > 0) && (stride <= window_len));
+
+	if(strcmp(file_path, "-") == 0) in = stdin;
+	else in = fopen(file_path, "rb");
+
+	if(in == NULL) {
+		printf("Error: could not open '%s'\n", file_path);
+		return -1;
+	}
+
+	index = 0;
+	start = 0;
+	if(stream_read(in, buffer.data(), window_len, follow)) {
+		monitor(buffer.data(), window_len, stride, index, 0, context);
+		index++;
+
+		while(stream_read(in, buffer.data() + start + window_len, stride, follow)) {
+			monitor(buffer.data() + start, window_len, stride, index, index*stride, context);
+			index++;
+
+			start += stride;
+			if(start + window_len + stride > (long)buffer.size()) {
+				memmove(buffer.data(), buffer.data() + start, window_len);
+				start = 0;
+			}
+		}
+	}
+
+	if(in != stdin) fclose(in);
+
+	return index;
+}
+
+bool parse_slice_range(const char *spec, struct slice_range *range) {
+	char *next;
+
+	errno = 0;
+	if(strncmp(spec, "all,", 4) == 0) {
+		range->first = 0;
+		range->last = LONG_MAX;
+		next = (char *)spec + 3;
+	} else {
+		range->first = strtol(spec, &next, 0);
+		range->last = range->first;
+		if(*next == '-') range->last = strtol(next + 1, &next, 0);
+	}
+
+	if((errno != 0) || (*next != ',') || (range->first < 0) || (range->last < range->first)) return false;
+
+	range->subset_len = strtol(next + 1, &next, 0);
+	return (errno == 0) && (*next == '\0') && (range->subset_len > 0);
+}
+
+long slice_assessment(const char *file_path, const vector<struct slice_range> &ranges, int worker_count, window_assessor assess, void *context) {
+	const byte *buffer;
+	long file_len;
+	vector<long> offsets, lengths, indices;
+	struct stream_output output;
+
+	if(!map_file(file_path, &buffer, &file_len)) return -1;
+
+	for(size_t i = 0; i < ranges.size(); i++) {
+		for(long j = ranges[i].first; j <= ranges[i].last; j++) {
+			long offset = j * ranges[i].subset_len;
+
+			if(offset >= file_len) break;
+			indices.push_back(j);
+			offsets.push_back(offset);
+			lengths.push_back(min(ranges[i].subset_len, file_len - offset));
+		}
+	}
+
+	output.next_index = 0;
+
+	//Each thread copies out only the subset it is assessing, so just worker_count copies exist at once
+	#pragma omp parallel for schedule(dynamic, 1) num_threads(worker_count)
+	for(long i = 0; i < (long)indices.size(); i++) {
+		struct stream_window slice;
+		char record[STREAM_RECORD_MAX];
+
+		slice.index = indices[i];
+		slice.offset = offsets[i];
+		slice.samples.assign(buffer + offsets[i], buffer + offsets[i] + lengths[i]);
+
+		record[0] = '\0';
+		assess(&slice, context, record, sizeof(record));
+		stream_emit(&output, i, record);
+	}
+
+	unmap_file(buffer, file_len);
+
+	return indices.size();
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "utils.h"
+
+#include <deque>
+#include <thread>			// std::thread
+#include <condition_variable>	// std::condition_variable
+#include <unistd.h>		// usleep
+#include <limits.h>		// LONG_MAX
+#include <omp.h>
+
+//How long to wait for a growing file to grow, in microseconds
+#define STREAM_POLL_USEC 100000
+//The longest result record produced for a window
+#define STREAM_RECORD_MAX 1024
+
+//A window of samples taken from a stream
+struct stream_window {
+	long index;		// the number of windows before this one
+	long offset;		// the position of the first sample of the window within the stream
+	vector<byte> samples;
+};
+
+//Assesses a single window, writing a one line result record (without the trailing newline) into record.
+//This is called concurrently from several threads.
+typedef void (*window_assessor)(const struct stream_window *window, void *context, char *record, size_t record_len);
+
+//A bounded queue of windows, shared between the reader and the worker threads.
+//The reader blocks when the queue is full, so the memory used doesn't depend on the length of the stream.
+class WindowQueue {
+public:
+	WindowQueue(size_t depth) : depth(depth), closed(false) {}
+
+	//Blocks until there is space in the queue
+	void push(struct stream_window *window) {
+		unique_lock<mutex> lock(queue_mutex);
+		not_full.wait(lock, [this]{ return windows.size() < depth; });
+		windows.push_back(window);
+		not_empty.notify_one();
+	}
+
+	//Blocks until there is a window to process. Returns NULL once the queue is closed and drained.
+	struct stream_window *pop() {
+		struct stream_window *window;
+		unique_lock<mutex> lock(queue_mutex);
+
+		not_empty.wait(lock, [this]{ return closed || !windows.empty(); });
+		if(windows.empty()) return NULL;
+
+		window = windows.front();
+		windows.pop_front();
+		not_full.notify_one();
+		return window;
+	}
+
+	//No more windows will be pushed
+	void close() {
+		lock_guard<mutex> lock(queue_mutex);
+		closed = true;
+		not_empty.notify_all();
+	}
+
+private:
+	size_t depth;
+	bool closed;
+	deque<struct stream_window *> windows;
+	mutex queue_mutex;
+	condition_variable not_full;
+	condition_variable not_empty;
+};
+
+//The workers finish windows out of order, but the records are printed in stream order.
+struct stream_output {
+	mutex output_mutex;
+	long next_index;
+	map<long, string> pending;
+};
+
+//Reads exactly len bytes. At the end of the input, this either waits for more data (when following a
+//growing file) or returns false.
+bool stream_read(FILE *in, byte *buffer, long len, bool follow);
+
+//Discards len bytes from the input
+bool stream_skip(FILE *in, long len, bool follow);
+
+//Prints the record for the position'th window, along with any later records that were waiting for it
+void stream_emit(struct stream_output *output, long position, const char *record);
+
+void stream_worker(WindowQueue *queue, struct stream_output *output, window_assessor assess, void *context);
+
+//Reads windows of window_len samples, each starting stride samples after the last, from the named file
+//("-" for standard input) and assesses them using worker_count threads. One record is printed per window.
+//If follow is true, the end of the file is treated as a pause in a growing file rather than the end of the stream.
+//Returns the number of windows assessed, or -1 if the input couldn't be opened.
+long stream_assessment(const char *file_path, long window_len, long stride, bool follow, int worker_count, size_t queue_depth, window_assessor assess, void *context);
+
+//Called for each window in monitoring mode. For the first window (index 0), samples holds just that window;
+//for each later window, samples holds the previous window followed by the stride samples that were just read,
+//so that incremental estimators can slide from one window to the next.
+typedef void (*window_monitor)(const byte *samples, long window_len, long stride, long index, long offset, void *context);
+
+//Reads overlapping windows from the named file ("-" for standard input) and hands them to monitor in order,
+//in the calling thread. stride must be no larger than window_len. Returns the number of windows, or -1 if the
+//input couldn't be opened.
+long stream_monitor(const char *file_path, long window_len, long stride, bool follow, window_monitor monitor, void *context);
+
+//A run of consecutive subsets requested with -l: subsets first through last, each of subset_len samples
+struct slice_range {
+	long first;
+	long last;	// LONG_MAX for every subset up to the end of the file
+	long subset_len;
+};
+
+//Parses "<index>,<samples>", "<first>-<last>,<samples>" or "all,<samples>"
+bool parse_slice_range(const char *spec, struct slice_range *range);
+
+//Assesses the requested subsets of the file using worker_count threads, printing one record per subset in the
+//order requested. The file is mapped once and shared by every thread, rather than being reopened and read for
+//each subset. As with read_file_subset, the last subset of the file may be short; subsets that start past the
+//end of the file are skipped. Returns the number of subsets assessed, or -1 if the file couldn't be mapped.
+long slice_assessment(const char *file_path, const vector<struct slice_range> &ranges, int worker_count, window_assessor assess, void *context);
@@ -0,0 +1,70 @@
+#include "transpose.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//Transposes the TRANSPOSE_TILE x TRANSPOSE_TILE tile at src (with row length src_stride) into dst (with row length dst_stride)
+//or, for the partial tiles on the right and bottom edges, the tile_rows x tile_cols corner of it.
+static inline void transpose_tile_scalar(const byte *src, long src_stride, byte *dst, long dst_stride, long tile_rows, long tile_cols) {
+	for(long i = 0; i < tile_rows; i++) {
+		for(long j = 0; j < tile_cols; j++) {
+			dst[j*dst_stride + i] = src[i*src_stride + j];
+		}
+	}
+}
+
+#ifdef __SSE2__
+//A full 16x16 tile, transposed in registers by successively interleaving 8, 16, 32 and 64 bit lanes.
+static inline void transpose_tile_sse2(const byte *src, long src_stride, byte *dst, long dst_stride) {
+	__m128i r[16], t[16];
+
+	for(int i = 0; i < 16; i++) r[i] = _mm_loadu_si128((const __m128i *)(src + i*src_stride));
+
+	//t[2i] holds the byte pairs of rows 2i and 2i+1 for columns 0-7, t[2i+1] those for columns 8-15
+	for(int i = 0; i < 8; i++) {
+		t[2*i] = _mm_unpacklo_epi8(r[2*i], r[2*i+1]);
+		t[2*i+1] = _mm_unpackhi_epi8(r[2*i], r[2*i+1]);
+	}
+
+	//r[4g+m] holds rows 4g to 4g+3 of columns 4m to 4m+3
+	for(int g = 0; g < 4; g++) {
+		r[4*g] = _mm_unpacklo_epi16(t[4*g], t[4*g+2]);
+		r[4*g+1] = _mm_unpackhi_epi16(t[4*g], t[4*g+2]);
+		r[4*g+2] = _mm_unpacklo_epi16(t[4*g+1], t[4*g+3]);
+		r[4*g+3] = _mm_unpackhi_epi16(t[4*g+1], t[4*g+3]);
+	}
+
+	//t[8h+m] holds rows 8h to 8h+7 of columns 2m and 2m+1
+	for(int h = 0; h < 2; h++) {
+		for(int m = 0; m < 4; m++) {
+			t[8*h+2*m] = _mm_unpacklo_epi32(r[8*h+m], r[8*h+4+m]);
+			t[8*h+2*m+1] = _mm_unpackhi_epi32(r[8*h+m], r[8*h+4+m]);
+		}
+	}
+
+	//Each column is now split between t[m] (rows 0-7) and t[8+m] (rows 8-15)
+	for(int m = 0; m < 8; m++) {
+		_mm_storeu_si128((__m128i *)(dst + (2*m)*dst_stride), _mm_unpacklo_epi64(t[m], t[8+m]));
+		_mm_storeu_si128((__m128i *)(dst + (2*m+1)*dst_stride), _mm_unpackhi_epi64(t[m], t[8+m]));
+	}
+}
+#endif
+
+void transpose_matrix(const byte *src, byte *dst, long rows, long cols) {
+	for(long i = 0; i < rows; i += TRANSPOSE_TILE) {
+		long tile_rows = min((long)TRANSPOSE_TILE, rows - i);
+
+		for(long j = 0; j < cols; j += TRANSPOSE_TILE) {
+			long tile_cols = min((long)TRANSPOSE_TILE, cols - j);
+
+#ifdef __SSE2__
+			if((tile_rows == TRANSPOSE_TILE) && (tile_cols == TRANSPOSE_TILE)) {
+				transpose_tile_sse2(src + i*cols + j, cols, dst + j*rows + i, rows);
+				continue;
+			}
+#endif
+			transpose_tile_scalar(src + i*cols + j, cols, dst + j*rows + i, rows, tile_rows, tile_cols);
+		}
+	}
+}
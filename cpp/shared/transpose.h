@@ -0,0 +1,11 @@
+#pragma once
+
+#include "utils.h"
+
+//The matrix is transposed in square tiles of this many bytes on a side, so that both the reads
+//and the writes stay within a small number of cache lines.
+#define TRANSPOSE_TILE 16
+
+//Transposes the rows x cols matrix src (stored row-major) into the cols x rows matrix dst, so that
+//dst[j*rows + i] = src[i*cols + j]. src and dst must not overlap.
+void transpose_matrix(const byte *src, byte *dst, long rows, long cols);
@@ -0,0 +1,830 @@
+#include "utils.h"
+#include "profile.h"
+
+#include <stdarg.h>		// va_list
+#include <tuple>			// std::tuple
+
+bool relEpsilonEqual(double A, double B, double maxAbsFactor, double maxRelFactor, uint32_t maxULP)
+{
+   double diff;
+   double absA, absB;
+   uint64_t Aint;
+   uint64_t Bint;
+
+   assert(sizeof(uint64_t) == sizeof(double));
+   assert(maxAbsFactor >= 0.0);
+   assert(maxRelFactor >= 0.0);
+
+   ///NaN is by definition not equal to anything (including itself)
+   if(std::isnan(A) || std::isnan(B)) {
+      return false;
+   }
+
+   //Deals with equal infinities, and the corner case where they are actually copies
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+   if(A==B) {
+      return true;
+   }
+#pragma GCC diagnostic pop
+
+   //If either is infinity, but they are not equal, then they aren't close.
+   if(std::isinf(A) || std::isinf(B)) {
+      return false;
+   }
+
+   absA = fabs(A);
+   absB = fabs(B);
+   //Make sure that A is the closest to 0.
+   if(absA > absB) {
+      double tmp;
+
+      //Swap A and B
+      tmp = B;
+      B=A;
+      A=tmp;
+
+      //Swap absA and absB
+      tmp = absB;
+      absB = absA;
+      absA = tmp;
+   }
+
+   //Capture the difference of the largest magnitude from the smallest magnitude
+   diff=fabs(B-A);
+
+   //Is absA, diff, or absB * maxRelFactor subnormal?
+   //Did diff overflow?
+   //if absA is subnormal (effectively 0) or 0, then relative difference isn't meaningful, as fabs(B-A)/B≈1 for all values of B
+   //In the instance of overflows, the resulting relative comparison will be nonsense.
+   if((absA < DBL_MIN) || (diff < DBL_MIN) || std::isinf(diff) || (absB * maxRelFactor < DBL_MIN)) {
+      //Yes. Relative closeness is going to be nonsense
+      return diff <= maxAbsFactor;
+   } else {
+      //No. Using relative closeness is probably the right thing to do.
+      //Proceeding roughly as per Knuth AoCP vol II (section 4.2.2)
+      if(diff <= absB * maxRelFactor) {
+         //These are relatively close
+         return true;
+      } 
+   }
+
+   //Neither A or B is subnormal, and they aren't close in the conventional sense, 
+   //but perhaps that's just due to IEEE representation. Check to see if the value is within maxULP ULPs.
+
+   //We can't meaningfully compare non-zero values with 0.0 in this way,
+   //but absA >= DBL_MIN if we're here, so neither value is 0.0.
+
+   //if they aren't the same sign, then these can't be only a few ULPs away from each other
+   if(signbit(A) != signbit(B)) {
+      return false;
+   }
+
+   //Note, casting from one type to another is undefined behavior, but memcpy will necessarily work
+   memcpy(&Aint, &absA, sizeof(double));
+   memcpy(&Bint, &absB, sizeof(double));
+   //This should be true by the construction of IEEE doubles
+   assert(Bint > Aint);
+
+   return (Bint - Aint <= maxULP);
+}
+
+void free_data(data_t *dp){
+	if(dp->symbols != NULL) free(dp->symbols);
+	if(dp->rawsymbols != NULL) free(dp->rawsymbols);
+	if((dp->word_size > 1) && (dp->bsymbols != NULL)) free(dp->bsymbols);
+}
+
+int symbol_bit_width(const byte *symbols, long len) {
+	byte datamask = 0;
+	byte curbit = 0x80;
+	int i;
+
+	for(long j = 0; j < len; j++) {
+		datamask = datamask | symbols[j];
+	}
+
+	for(i=8; (i>0) && ((datamask & curbit) == 0); i--) {
+		curbit = curbit >> 1;
+	}
+
+	return i;
+}
+
+bool process_symbols(data_t *dp, byte *bits) {
+	int mask, j, max_symbols;
+	long i;
+	int width;
+
+	width = symbol_bit_width(dp->symbols, dp->len);
+
+	//Do we need to establish the word size?
+	if(dp->word_size == 0) {
+		dp->word_size = width;
+	} else {
+		if( width < dp->word_size ) {
+			printf("Warning: Symbols appear to be narrower than described.\n");
+		} else if( width > dp->word_size ) {
+			printf("Incorrect bit width specification: Data does not fit within described bit width.\n");
+			free(dp->symbols);
+			dp->symbols = NULL;
+			free(dp->rawsymbols);
+			dp->rawsymbols = NULL;
+			return false;
+		}
+	}
+
+	memcpy(dp->rawsymbols, dp->symbols, sizeof(byte)* dp->len);
+	dp->maxsymbol = 0;
+
+	max_symbols = 1 << dp->word_size;
+	int symbol_map_down_table[max_symbols];
+
+	// create symbols (samples) and check if they need to be mapped down
+	dp->alph_size = 0;
+	memset(symbol_map_down_table, 0, max_symbols*sizeof(int));
+	mask = max_symbols-1;
+	for(i = 0; i < dp->len; i++){ 
+		dp->symbols[i] &= mask;
+		if(dp->symbols[i] > dp->maxsymbol) dp->maxsymbol = dp->symbols[i];
+		if(symbol_map_down_table[dp->symbols[i]] == 0) symbol_map_down_table[dp->symbols[i]] = 1;
+	}
+
+	for(i = 0; i < max_symbols; i++){
+		if(symbol_map_down_table[i] != 0) symbol_map_down_table[i] = (byte)dp->alph_size++;
+	}
+
+	// create bsymbols (bitstring) using the non-mapped data
+	dp->blen = dp->len * dp->word_size;
+	if(dp->word_size == 1) dp->bsymbols = dp->symbols;
+	else{
+		dp->bsymbols = (bits != NULL) ? bits : (byte*)malloc(dp->blen);
+		if(dp->bsymbols == NULL){
+			printf("Error: failure to initialize memory for bsymbols\n");
+			free(dp->symbols);
+			dp->symbols = NULL;
+			free(dp->rawsymbols);
+			dp->rawsymbols = NULL;
+
+			return false;
+		}
+
+		for(i = 0; i < dp->len; i++){
+			for(j = 0; j < dp->word_size; j++){
+				dp->bsymbols[i*dp->word_size+j] = (dp->symbols[i] >> (dp->word_size-1-j)) & 0x1;
+			}
+		}
+	}
+
+	// map down symbols if less than 2^bits_per_word unique symbols
+	if(dp->alph_size < dp->maxsymbol + 1){
+		for(i = 0; i < dp->len; i++) dp->symbols[i] = (byte)symbol_map_down_table[dp->symbols[i]];
+	} 
+
+	return true;
+}
+
+bool alloc_symbols(data_t *dp, long len) {
+	dp->len = len;
+	dp->symbols = (byte*)malloc(sizeof(byte)*dp->len);
+	dp->rawsymbols = (byte*)malloc(sizeof(byte)*dp->len);
+	if((dp->symbols == NULL) || (dp->rawsymbols == NULL)){
+		printf("Error: failure to initialize memory for symbols\n");
+		if(dp->symbols != NULL) {
+			free(dp->symbols);
+			dp->symbols = NULL;
+		}
+		if(dp->rawsymbols != NULL) {
+			free(dp->rawsymbols);
+			dp->rawsymbols = NULL;
+		}
+		return false;
+	}
+
+	return true;
+}
+
+bool read_buffer(const byte *buffer, long len, data_t *dp) {
+	if(len <= 0){
+		printf("Error: buffer is empty\n");
+		return false;
+	}
+
+	if(!alloc_symbols(dp, len)) return false;
+	memcpy(dp->symbols, buffer, sizeof(byte)*len);
+
+	return process_symbols(dp);
+}
+
+bool read_file_subset(const char *file_path, data_t *dp, unsigned long subsetIndex, unsigned long subsetSize) {
+	FILE *file; 
+	long rc;
+	long fileLen, len;
+
+	file = fopen(file_path, "rb");
+	if(!file){
+		printf("Error: could not open '%s'\n", file_path);
+		return false;
+	}
+
+	rc = (long)fseek(file, 0, SEEK_END);
+	if(rc < 0){
+		printf("Error: fseek failed\n");
+		fclose(file);
+		return false;
+	}
+
+	fileLen = ftell(file);
+	if(fileLen < 0){
+		printf("Error: ftell failed\n");
+		fclose(file);
+		return false;
+	}
+
+	rewind(file);
+
+	if(subsetSize == 0) {
+		len = fileLen;
+	} else {
+		rc = (long)fseek(file, subsetIndex*subsetSize, SEEK_SET);
+		if(rc < 0){
+			printf("Error: fseek failed\n");
+			fclose(file);
+			return false;
+		}
+
+		len = min(fileLen - subsetIndex*subsetSize, subsetSize);
+	}
+
+	if(len == 0){
+		printf("Error: '%s' is empty\n", file_path);
+		fclose(file);
+		return false;
+	}
+
+	if(!alloc_symbols(dp, len)) {
+		fclose(file);
+		return false;
+	}
+
+	rc = fread(dp->symbols, sizeof(byte), dp->len, file);
+	if(rc != dp->len){
+		printf("Error: file read failure\n");
+		fclose(file);
+		free(dp->symbols);
+		dp->symbols = NULL;
+		free(dp->rawsymbols);
+		dp->rawsymbols = NULL;
+		return false;
+	}
+	fclose(file);
+
+	return process_symbols(dp);
+}
+
+bool read_file(const char *file_path, data_t *dp){
+	return read_file_subset(file_path, dp, 0, 0);
+}
+
+bool map_file(const char *file_path, const byte **buffer, long *len) {
+	int fd;
+	struct stat st;
+	void *mapping;
+
+	fd = open(file_path, O_RDONLY);
+	if(fd < 0){
+		printf("Error: could not open '%s'\n", file_path);
+		return false;
+	}
+
+	if(fstat(fd, &st) < 0){
+		printf("Error: fstat failed\n");
+		close(fd);
+		return false;
+	}
+
+	if(st.st_size == 0){
+		printf("Error: '%s' is empty\n", file_path);
+		close(fd);
+		return false;
+	}
+
+	mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(mapping == MAP_FAILED){
+		printf("Error: could not map '%s'\n", file_path);
+		return false;
+	}
+
+	//The file is read front to back
+	madvise(mapping, st.st_size, MADV_SEQUENTIAL);
+
+	*buffer = (const byte *)mapping;
+	*len = st.st_size;
+	return true;
+}
+
+void unmap_file(const byte *buffer, long len) {
+	munmap((void *)buffer, len);
+}
+
+void xoshiro_jump(unsigned int jump_count, uint64_t *xoshiro256starstarState) {
+	static const uint64_t JUMP[] = { 0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c };
+
+	for(unsigned int j=0; j < jump_count; j++) {
+		//Each jump starts from a clear accumulator
+		uint64_t s0 = 0;
+		uint64_t s1 = 0;
+		uint64_t s2 = 0;
+		uint64_t s3 = 0;
+
+		for(unsigned int i = 0; i < sizeof JUMP / sizeof *JUMP; i++)
+			for(unsigned int b = 0; b < 64; b++) {
+				if (JUMP[i] & ((uint64_t)1) << b) {
+					s0 ^= xoshiro256starstarState[0];
+					s1 ^= xoshiro256starstarState[1];
+					s2 ^= xoshiro256starstarState[2];
+					s3 ^= xoshiro256starstarState[3];
+				}
+				xoshiro256starstar(xoshiro256starstarState);	
+			}
+			
+		xoshiro256starstarState[0] = s0;
+		xoshiro256starstarState[1] = s1;
+		xoshiro256starstarState[2] = s2;
+		xoshiro256starstarState[3] = s3;
+	}
+}
+
+bool seed(uint64_t *xoshiro256starstarState){
+	FILE *infp;
+
+	if((infp=fopen("/dev/urandom", "rb"))==NULL) {
+		perror("Can't open random source");
+		return false;
+	} 
+
+	if(fread(xoshiro256starstarState, sizeof(uint64_t), 4, infp)!=4) {
+		perror("Can't read random seed");
+		fclose(infp);
+		return false;
+	}
+
+	if(fclose(infp)!=0) {
+		perror("Couldn't close random source");
+		return false;
+	}
+
+	return true;
+}
+
+uint64_t randomRange64(uint64_t s, uint64_t *xoshiro256starstarState){
+	uint64_t x;
+	__uint128_t m;
+	uint64_t l;
+
+	x = xoshiro256starstar(xoshiro256starstarState);
+
+	if(UINT64_MAX == s) {
+		return x;
+	} else {
+		s++; // We want an integer in the range [0,s], not [0,s)
+		m = (__uint128_t)x * (__uint128_t)s;
+		l = (uint64_t)m; //This is m mod 2^64
+
+		if(l<s) {
+			uint64_t t = ((uint64_t)(-s)) % s; //t = (2^64 - s) mod s (by definition of unsigned arithmetic in C)
+			while(l < t) {
+				x = xoshiro256starstar(xoshiro256starstarState);
+				m = (__uint128_t)x * (__uint128_t)s;
+				l = (uint64_t)m; //This is m mod 2^64
+			}
+		}
+
+		return (uint64_t)(m >> 64U); //return floor(m/2^64)
+	}
+}
+
+double randomUnit(uint64_t *xoshiro256starstarState) {
+	return((xoshiro256starstar(xoshiro256starstarState) >> 11) * 1.1102230246251565e-16);
+}
+
+void random_stream_init(struct random_stream *rs, const uint64_t *xoshiro256starstarState, unsigned int first_jump) {
+	uint64_t laneState[4];
+
+	memcpy(laneState, xoshiro256starstarState, sizeof(laneState));
+	xoshiro_jump(first_jump, laneState);
+
+	for(int k = 0; k < XOSHIRO_LANES; k++) {
+		if(k > 0) xoshiro_jump(1, laneState);
+		for(int j = 0; j < 4; j++) rs->state[j][k] = laneState[j];
+	}
+
+	rs->next = RANDOM_BUFFER_LEN;
+}
+
+void random_stream_init_keyed(struct random_stream *rs, uint64_t key, uint64_t index) {
+	uint64_t x = key;
+	uint64_t y = index;
+
+	x ^= splitmix64(&y);
+	for(int k = 0; k < XOSHIRO_LANES; k++) {
+		for(int j = 0; j < 4; j++) rs->state[j][k] = splitmix64(&x);
+	}
+
+	rs->next = RANDOM_BUFFER_LEN;
+}
+
+#ifdef CPU_DISPATCH
+TARGET_AVX2 static inline __m256i rotl_avx2(const __m256i x, int k) {
+	return _mm256_or_si256(_mm256_slli_epi64(x, k), _mm256_srli_epi64(x, 64 - k));
+}
+
+//xoshiro256** on four lanes at once. AVX2 has no 64-bit multiply, so the multiplications by 5 and 9 are
+//done as shifts and adds.
+TARGET_AVX2 static void random_stream_refill_avx2(struct random_stream *rs) {
+	__m256i s0 = _mm256_loadu_si256((const __m256i *)rs->state[0]);
+	__m256i s1 = _mm256_loadu_si256((const __m256i *)rs->state[1]);
+	__m256i s2 = _mm256_loadu_si256((const __m256i *)rs->state[2]);
+	__m256i s3 = _mm256_loadu_si256((const __m256i *)rs->state[3]);
+
+	for(int i = 0; i < RANDOM_BUFFER_LEN; i += 4) {
+		const __m256i times5 = _mm256_add_epi64(_mm256_slli_epi64(s1, 2), s1);
+		const __m256i rotated = rotl_avx2(times5, 7);
+		const __m256i t = _mm256_slli_epi64(s1, 17);
+
+		_mm256_storeu_si256((__m256i *)(rs->buffer + i), _mm256_add_epi64(_mm256_slli_epi64(rotated, 3), rotated));
+
+		s2 = _mm256_xor_si256(s2, s0);
+		s3 = _mm256_xor_si256(s3, s1);
+		s1 = _mm256_xor_si256(s1, s2);
+		s0 = _mm256_xor_si256(s0, s3);
+		s2 = _mm256_xor_si256(s2, t);
+		s3 = rotl_avx2(s3, 45);
+	}
+
+	_mm256_storeu_si256((__m256i *)rs->state[0], s0);
+	_mm256_storeu_si256((__m256i *)rs->state[1], s1);
+	_mm256_storeu_si256((__m256i *)rs->state[2], s2);
+	_mm256_storeu_si256((__m256i *)rs->state[3], s3);
+}
+#endif
+
+void random_stream_refill(struct random_stream *rs) {
+#ifdef CPU_DISPATCH
+	if((XOSHIRO_LANES == 4) && (cpu_isa() >= CPU_ISA_AVX2)) {
+		random_stream_refill_avx2(rs);
+		rs->next = 0;
+		return;
+	}
+#endif
+
+	for(int i = 0; i < RANDOM_BUFFER_LEN; i += XOSHIRO_LANES) {
+		for(int k = 0; k < XOSHIRO_LANES; k++) {
+			const uint64_t t = rs->state[1][k] << 17;
+
+			rs->buffer[i + k] = rotl(rs->state[1][k] * 5, 7) * 9;
+
+			rs->state[2][k] ^= rs->state[0][k];
+			rs->state[3][k] ^= rs->state[1][k];
+			rs->state[1][k] ^= rs->state[2][k];
+			rs->state[0][k] ^= rs->state[3][k];
+			rs->state[2][k] ^= t;
+			rs->state[3][k] = rotl(rs->state[3][k], 45);
+		}
+	}
+	rs->next = 0;
+}
+
+long int sum(const byte arr[], const int sample_size) {
+	long int sum = 0;
+	for (long int i = 0; i < sample_size; ++i) {
+		sum += arr[i];
+	}
+
+	return sum;
+}
+
+void calc_stats(const data_t *dp, double &rawmean, double &median) {
+
+	// Calculate mean
+	rawmean = sum(dp->rawsymbols, dp->len) / (double)dp->len;
+
+	// Sort in a vector for median/min/max
+	vector<byte> v(dp->symbols, dp->symbols + dp->len);
+	sort(v.begin(), v.end());
+
+	long int half = dp->len / 2;
+	if(dp->alph_size == 2) {
+		//This isn't necessarily true, but we are supposed to set it this way.
+		//See 5.1.5, 5.1.6.
+		median = 0.5;
+	} else {
+		if((dp->len & 1) == 1) {
+			//the length is odd
+			median = v[half];
+		} else {
+			//the length is even
+			median = (v[half] + v[half - 1]) / 2.0;
+		}
+	}
+}
+
+void map_init(map<byte, int> &m) {
+	for (int i = 0; i < 256; i++) {
+		m[i] = 0;
+	}
+}
+
+void map_init(map<byte, double> &m) {
+	for (int i = 0; i < 256; i++) {
+		m[i] = 0.0;
+	}
+}
+
+void map_init(map<pair<byte, byte>, int> &m) {
+	for (int i = 0; i < 256; i++) {
+		for (int j = 0; j < 256; j++) {
+			m[pair<byte, byte>(i, j)] = 0;
+		}
+	}
+}
+
+void calc_proportions(const byte data[], vector<double> &p, const int sample_size) {
+	for (int i = 0; i < sample_size; i++) {
+		p[data[i]] += (1.0 / sample_size);
+	}
+}
+
+void calc_counts(const byte data[], vector<int> &c, const int sample_size) {
+	for (int i = 0; i < sample_size; i++) {
+		c[data[i]] ++;
+	}
+}
+
+double std_dev(const vector<int> x, const double x_mean) {
+	double sum = 0.0;
+
+	for (unsigned int i = 0; i < x.size(); i++) {
+		sum += pow(x[i] - x_mean, 2);
+	}
+
+	return sqrt(sum / x.size());
+}
+
+long int n_choose_2(const long int n) {
+	return ((n*n) - n) / 2;
+}
+
+vector<byte> substr(const byte text[], const int pos, const int len, const int sample_size) {
+	int substr_len = len;
+
+	if (pos + len > sample_size) {
+		substr_len = sample_size - pos;
+	}
+
+	vector<byte> substring;
+
+	for (int i = 0; i < substr_len; i++) {
+		substring.push_back(text[pos + i]);
+	}
+
+	return substring;
+}
+
+array<byte, 16> fast_substr(const byte text[], const int pos, const int len) {
+	array<byte, 16> substring = { 0 };
+
+	for (int i = 0; i < len; i++) {
+		substring[i] = text[pos + i];
+	}
+
+	return substring;
+}
+
+double divide(const int a, const int b) {
+	return ((double)a / (double)b);
+}
+
+double prediction_estimate_function(long double p, long r, long N){
+	long double q, qpr, x, xlast=0.0L;
+	assert(p > 0.0L); //In fact, it is >= 1/k
+	assert(p < 1.0L);
+
+	q = 1.0L-p;
+	x = 1.0L;
+	//This factor doesn't change across the fixed point iterations
+	qpr = q*powl(p, r);
+
+	//We know that 
+	// * x is in the interval [1,1/p] which is a subset of [1,k]
+	// * the sequence is monotonic up (so x >= xlast).
+	//As such we don't need much fancyness for looking for "equality"
+	for(int i = 0; (i <= 65) && ((x - xlast) > (LDBL_EPSILON*x)); i++) {
+		xlast = x;
+		x = 1.0L + qpr*powl(x, r+1.0L);
+		//We expect this convergence to be monotonic up.
+		assert(x >= xlast);
+		//We expect x<=1/p
+		assert(p*x <= 1.0L);
+	}
+
+	return((double)(logl(1.0L-p*x) - logl((r+1.0L-r*x)*q) - (N+1.0L)*logl(x)));
+}
+
+//The same searches come up repeatedly: the rows and columns in restart testing, and repeated assessments
+//of the same data. The cache is keyed on every argument, so that a result doesn't depend on which searches
+//were run before it, and it is emptied when it is full.
+static map<tuple<long, long, double>, double> p_local_cache;
+static mutex p_local_cache_mutex;
+
+double calc_p_local(long max_run_len, long N, double ldomain){
+	int j;
+	int lastSide, sameSideCount;
+	double p, log_alpha;
+	double lastP, pVal;
+	double lvalue, hvalue;
+	double hbound, lbound;
+	double hdomain;
+	double lastStep;
+	bool nearRoot;
+	tuple<long, long, double> cacheKey(max_run_len+1, N, ldomain);
+
+	{
+		lock_guard<mutex> lock(p_local_cache_mutex);
+		map<tuple<long, long, double>, double>::iterator cached = p_local_cache.find(cacheKey);
+		if(cached != p_local_cache.end()) return cached->second;
+	}
+
+	// search for p_local
+	log_alpha = log(0.99);
+	
+	hdomain = 1.0;
+
+	lbound = ldomain;
+	hbound = hdomain;
+
+	lvalue = DBL_INFINITY;
+	hvalue = -DBL_INFINITY;
+
+	//lastSide is -1 if the last update moved lbound, and 1 if it moved hbound.
+	lastSide = 0;
+	sameSideCount = 0;
+	lastStep = 0.0;
+	nearRoot = false;
+
+	//Note that the bounds are in [0,1], so overflows aren't an issue
+	//But underflows are.
+	p = (lbound + hbound) / 2.0;
+	pVal = prediction_estimate_function(p, max_run_len+1, N);
+
+	//We don't need the initial pVal invariant, as our initial bounds are infinite.
+	//We don't need the initial bounds, as they are set to the domain bounds
+	for(j=0; j<ITERMAX; j++) {
+		int side;
+
+		profile_search_steps++;
+
+		//Have we reached "equality"?
+		if(relEpsilonEqual(pVal, log_alpha, ABSEPSILON, RELEPSILON, 4)) break;
+
+		//Now update based on the found pVal
+		if(log_alpha < pVal) {
+			lastStep = p - lbound;
+			lbound = p;
+			lvalue = pVal;
+			side = -1;
+		} else {
+			lastStep = hbound - p;
+			hbound = p;
+			hvalue = pVal;
+			side = 1;
+		}
+
+		//Close to the root the function value is dominated by rounding noise, and interpolation
+		//is no longer meaningful.
+		if(fabs(pVal - log_alpha) < P_LOCAL_NEAR_ROOT * fabs(log_alpha)) nearRoot = true;
+
+		if(side == lastSide) sameSideCount++;
+		else sameSideCount = 0;
+		lastSide = side;
+
+		//We now verify that ldomain <= lbound < p < hbound <= hdomain
+		//and that target in [ lvalue, hvalue ]
+		if(lbound >= hbound) {
+			p = fmin(fmax(lbound, hbound),hdomain);
+			break;
+		}
+
+		//invariant. If this isn't true, then we can't evaluate here.
+		if(!(INCLOSEDINTERVAL(lbound, ldomain, hdomain) && INCLOSEDINTERVAL(hbound,  ldomain, hdomain))) {
+			p = hdomain;
+			break;
+		}
+
+		//invariant. If this isn't true, then seeking the value within this interval doesn't make sense.
+		if(!INCLOSEDINTERVAL(log_alpha, lvalue, hvalue)) {
+			p = hdomain;
+			break;
+		}
+
+		//Update p
+		lastP = p;
+		p = (lbound + hbound) / 2.0;
+		//We can only interpolate once there are function values at both ends of the bracket
+		if(!std::isinf(lvalue) && !std::isinf(hvalue) && !nearRoot && (sameSideCount < 3)) {
+			double interp = lbound + (hbound - lbound) * ((lvalue - log_alpha) / (lvalue - hvalue));
+
+			if(sameSideCount > 0) {
+				//Overshoot the interpolated root, away from the end of the bracket that keeps moving.
+				interp -= (double)side * lastStep;
+			}
+
+			if(INOPENINTERVAL(interp,  lbound, hbound)) p = interp;
+		}
+
+		//invariant. If this isn't true, then further calculation isn't really meaningful.
+		if(!INOPENINTERVAL(p,  lbound, hbound)) {
+			p = hbound;
+			break;
+		}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+		//Look for a cycle
+		if(lastP == p) {
+			p = hbound;
+			break;
+		}
+#pragma GCC diagnostic pop
+
+		pVal = prediction_estimate_function(p, max_run_len+1, N);
+
+		//invariant: If this isn't true, then this isn't loosely monotonic
+		if(!INCLOSEDINTERVAL(pVal, lvalue, hvalue)) {
+			p = hbound;
+			break;
+		}
+	}//for loop
+
+	{
+		lock_guard<mutex> lock(p_local_cache_mutex);
+		if(p_local_cache.size() >= P_LOCAL_CACHE_MAX) p_local_cache.clear();
+		p_local_cache[cacheKey] = p;
+	}
+
+	return p;
+}
+
+thread_local FILE *verbose_stream = NULL;
+
+int verbose_printf(const char *format, ...) {
+	va_list args;
+	int written;
+
+	va_start(args, format);
+	written = vfprintf((verbose_stream != NULL) ? verbose_stream : stdout, format, args);
+	va_end(args);
+
+	return written;
+}
+
+double predictionEstimate(long C, long N, long max_run_len, long k, const char *testname, const int verbose, const char *label) {
+	double curMax;
+	double p_local=-1.0;
+	double entEst;
+	double p_global;
+	double p_globalPrime;
+
+	curMax = 1.0 / ((double)k);
+
+	p_global = (double)C/(double)N;
+
+	if(p_global > 0) p_globalPrime = min(1.0, p_global + ZALPHA*sqrt((p_global*(1.0-p_global))/((double)N-1.0)));
+	else p_globalPrime = 1.0 - pow(0.01, 1.0/(double)N);
+
+	curMax = fmax(curMax, p_globalPrime);
+	if((curMax < 1.0) && (prediction_estimate_function(curMax, max_run_len+1, N) > log(0.99))) {
+		p_local = calc_p_local(max_run_len, N, curMax);
+		curMax = fmax(curMax, p_local);
+	}
+
+	entEst = -log2(curMax);
+
+	if(verbose == 1) {
+		if(p_local > 0.0) verbose_printf("%s %s Prediction Estimate: N = %ld, Pglobal' = %.17g (C = %ld) Plocal = %.17g (r = %ld)\n", label, testname, N, p_globalPrime, C, p_local, max_run_len+1);
+		else verbose_printf("%s %s Prediction Estimate: N = %ld, Pglobal' = %.17g (C = %ld) Plocal can't affect result (r = %ld)\n", label, testname, N, p_globalPrime, C, max_run_len+1);
+	} else if(verbose == 2) {
+		verbose_printf("%s %s Prediction Estimate: C = %ld\n", label, testname, C);
+		verbose_printf("%s %s Prediction Estimate: r = %ld\n", label, testname, max_run_len + 1);
+		verbose_printf("%s %s Prediction Estimate: N = %ld\n", label, testname, N);
+		verbose_printf("%s %s Prediction Estimate: P_global = %.17g\n", label, testname, p_global);
+		verbose_printf("%s %s Prediction Estimate: P_global' = %.17g\n", label, testname, p_globalPrime);
+
+		if(p_local > 0.0) verbose_printf("%s %s Prediction Estimate: P_local = %.17g\n", label, testname, p_local);
+		else verbose_printf("%s %s Prediction Estimate: P_local can't change the result.\n", label, testname);
+
+		verbose_printf("%s %s Prediction Estimate: min entropy = %.17g\n", label, testname, entEst);
+	}
+	return entEst;
+}
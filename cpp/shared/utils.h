@@ -19,6 +19,12 @@
 #include <assert.h>
 #include <cfloat>
 #include <math.h>
+#include <fcntl.h>		// open
+#include <unistd.h>		// close
+#include <sys/mman.h>	// mmap
+#include <sys/stat.h>	// fstat
+
+#include "cpu_dispatch.h"
 
 #define SWAP(x, y) do { int s = x; x = y; y = s; } while(0)
 #define INOPENINTERVAL(x, a, b) (((a)>(b))?(((x)>(b))&&((x)<(a))):(((x)>(a))&&((x)<(b))))
@@ -61,412 +67,35 @@ using namespace std;
 //https://www.boost.org/doc/libs/1_62_0/libs/test/doc/html/boost_test/testing_tools/extended_comparison/floating_point/floating_points_comparison_theory.html
 //Knuth AoCP vol II (section 4.2.2)
 //Tested using modified test cases from https://floating-point-gui.de/errors/NearlyEqualsTest.java
-bool relEpsilonEqual(double A, double B, double maxAbsFactor, double maxRelFactor, uint32_t maxULP)
-{
-   double diff;
-   double absA, absB;
-   uint64_t Aint;
-   uint64_t Bint;
-
-   assert(sizeof(uint64_t) == sizeof(double));
-   assert(maxAbsFactor >= 0.0);
-   assert(maxRelFactor >= 0.0);
-
-   ///NaN is by definition not equal to anything (including itself)
-   if(std::isnan(A) || std::isnan(B)) {
-      return false;
-   }
-
-   //Deals with equal infinities, and the corner case where they are actually copies
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wfloat-equal"
-   if(A==B) {
-      return true;
-   }
-#pragma GCC diagnostic pop
-
-   //If either is infinity, but they are not equal, then they aren't close.
-   if(std::isinf(A) || std::isinf(B)) {
-      return false;
-   }
-
-   absA = fabs(A);
-   absB = fabs(B);
-   //Make sure that A is the closest to 0.
-   if(absA > absB) {
-      double tmp;
-
-      //Swap A and B
-      tmp = B;
-      B=A;
-      A=tmp;
-
-      //Swap absA and absB
-      tmp = absB;
-      absB = absA;
-      absA = tmp;
-   }
-
-   //Capture the difference of the largest magnitude from the smallest magnitude
-   diff=fabs(B-A);
-
-   //Is absA, diff, or absB * maxRelFactor subnormal?
-   //Did diff overflow?
-   //if absA is subnormal (effectively 0) or 0, then relative difference isn't meaningful, as fabs(B-A)/B≈1 for all values of B
-   //In the instance of overflows, the resulting relative comparison will be nonsense.
-   if((absA < DBL_MIN) || (diff < DBL_MIN) || std::isinf(diff) || (absB * maxRelFactor < DBL_MIN)) {
-      //Yes. Relative closeness is going to be nonsense
-      return diff <= maxAbsFactor;
-   } else {
-      //No. Using relative closeness is probably the right thing to do.
-      //Proceeding roughly as per Knuth AoCP vol II (section 4.2.2)
-      if(diff <= absB * maxRelFactor) {
-         //These are relatively close
-         return true;
-      } 
-   }
-
-   //Neither A or B is subnormal, and they aren't close in the conventional sense, 
-   //but perhaps that's just due to IEEE representation. Check to see if the value is within maxULP ULPs.
+bool relEpsilonEqual(double A, double B, double maxAbsFactor, double maxRelFactor, uint32_t maxULP);
 
-   //We can't meaningfully compare non-zero values with 0.0 in this way,
-   //but absA >= DBL_MIN if we're here, so neither value is 0.0.
 
-   //if they aren't the same sign, then these can't be only a few ULPs away from each other
-   if(signbit(A) != signbit(B)) {
-      return false;
-   }
+void free_data(data_t *dp); 
 
-   //Note, casting from one type to another is undefined behavior, but memcpy will necessarily work
-   memcpy(&Aint, &absA, sizeof(double));
-   memcpy(&Bint, &absB, sizeof(double));
-   //This should be true by the construction of IEEE doubles
-   assert(Bint > Aint);
+// Returns the number of bits needed to represent every symbol, using the highest order bit in use
+int symbol_bit_width(const byte *symbols, long len);
 
-   return (Bint - Aint <= maxULP);
-}
+// Establishes the word size (or checks the provided one), then builds the raw symbols, the
+// (possibly mapped down) symbols and the bitstring from the data already loaded into dp->symbols.
+// The bitstring is written to bits if it is given (it must hold len*word_size bits), and is
+// otherwise allocated. On failure, dp->symbols and dp->rawsymbols are freed.
+bool process_symbols(data_t *dp, byte *bits = NULL);
 
+// Allocates the symbol buffers for len samples
+bool alloc_symbols(data_t *dp, long len);
 
-void free_data(data_t *dp){
-	if(dp->symbols != NULL) free(dp->symbols);
-	if(dp->rawsymbols != NULL) free(dp->rawsymbols);
-	if((dp->word_size > 1) && (dp->bsymbols != NULL)) free(dp->bsymbols);
-} 
+// Read in the samples from a buffer already in memory (e.g., a region of a mapped file)
+bool read_buffer(const byte *buffer, long len, data_t *dp);
 
 // Read in binary file to test
-bool read_file_subset(const char *file_path, data_t *dp, unsigned long subsetIndex, unsigned long subsetSize) {
-	FILE *file; 
-	int mask, j, max_symbols;
-	long rc, i;
-	long fileLen;
-
-	file = fopen(file_path, "rb");
-	if(!file){
-		printf("Error: could not open '%s'\n", file_path);
-		return false;
-	}
-
-	rc = (long)fseek(file, 0, SEEK_END);
-	if(rc < 0){
-		printf("Error: fseek failed\n");
-		fclose(file);
-		return false;
-	}
-
-	fileLen = ftell(file);
-	if(fileLen < 0){
-		printf("Error: ftell failed\n");
-		fclose(file);
-		return false;
-	}
-
-	rewind(file);
+bool read_file_subset(const char *file_path, data_t *dp, unsigned long subsetIndex, unsigned long subsetSize);
 
-	if(subsetSize == 0) {
-		dp->len = fileLen;
-	} else {
-		rc = (long)fseek(file, subsetIndex*subsetSize, SEEK_SET);
-		if(rc < 0){
-			printf("Error: fseek failed\n");
-			fclose(file);
-			return false;
-		}
+bool read_file(const char *file_path, data_t *dp);
 
-		dp->len = min(fileLen - subsetIndex*subsetSize, subsetSize);
-	}
+// Maps a whole file read-only into memory. The mapping is released with unmap_file.
+bool map_file(const char *file_path, const byte **buffer, long *len);
 
-	if(dp->len == 0){
-		printf("Error: '%s' is empty\n", file_path);
-		fclose(file);
-		return false;
-	}
-
-	dp->symbols = (byte*)malloc(sizeof(byte)*dp->len);
-	dp->rawsymbols = (byte*)malloc(sizeof(byte)*dp->len);
-	if((dp->symbols == NULL) || (dp->rawsymbols == NULL)){
-		printf("Error: failure to initialize memory for symbols\n");
-		fclose(file);
-		if(dp->symbols != NULL) {
-			free(dp->symbols);
-			dp->symbols = NULL;
-		}
-		if(dp->rawsymbols != NULL) {
-			free(dp->rawsymbols);
-			dp->rawsymbols = NULL;
-		}
-		return false;
-	}
-
-	rc = fread(dp->symbols, sizeof(byte), dp->len, file);
-	if(rc != dp->len){
-		printf("Error: file read failure\n");
-		fclose(file);
-		free(dp->symbols);
-		dp->symbols = NULL;
-		free(dp->rawsymbols);
-		dp->rawsymbols = NULL;
-		return false;
-	}
-	fclose(file);
-
-	//Do we need to establish the word size?
-	if(dp->word_size == 0) {
-		byte datamask = 0;
-		byte curbit = 0x80;
-
-		for(i = 0; i < dp->len; i++) {
-			datamask = datamask | dp->symbols[i];
-		}
-
-		for(i=8; (i>0) && ((datamask & curbit) == 0); i--) {
-			curbit = curbit >> 1;
-		}
-
-		dp->word_size = i;
-	} else {
-		byte datamask = 0;
-		byte curbit = 0x80;
-
-		for(i = 0; i < dp->len; i++) {
-			datamask = datamask | dp->symbols[i];
-		}
-
-		for(i=8; (i>0) && ((datamask & curbit) == 0); i--) {
-			curbit = curbit >> 1;
-		}
-
-		if( i < dp->word_size ) {
-			printf("Warning: Symbols appear to be narrower than described.\n");
-		} else if( i > dp->word_size ) {
-			printf("Incorrect bit width specification: Data does not fit within described bit width.\n");
-			free(dp->symbols);
-			dp->symbols = NULL;
-			free(dp->rawsymbols);
-			dp->rawsymbols = NULL;
-			return false;
-		}
-	}
-
-	memcpy(dp->rawsymbols, dp->symbols, sizeof(byte)* dp->len);
-	dp->maxsymbol = 0;
-
-	max_symbols = 1 << dp->word_size;
-	int symbol_map_down_table[max_symbols];
-
-	// create symbols (samples) and check if they need to be mapped down
-	dp->alph_size = 0;
-	memset(symbol_map_down_table, 0, max_symbols*sizeof(int));
-	mask = max_symbols-1;
-	for(i = 0; i < dp->len; i++){ 
-		dp->symbols[i] &= mask;
-		if(dp->symbols[i] > dp->maxsymbol) dp->maxsymbol = dp->symbols[i];
-		if(symbol_map_down_table[dp->symbols[i]] == 0) symbol_map_down_table[dp->symbols[i]] = 1;
-	}
-
-	for(i = 0; i < max_symbols; i++){
-		if(symbol_map_down_table[i] != 0) symbol_map_down_table[i] = (byte)dp->alph_size++;
-	}
-
-	// create bsymbols (bitstring) using the non-mapped data
-	dp->blen = dp->len * dp->word_size;
-	if(dp->word_size == 1) dp->bsymbols = dp->symbols;
-	else{
-		dp->bsymbols = (byte*)malloc(dp->blen);
-		if(dp->bsymbols == NULL){
-			printf("Error: failure to initialize memory for bsymbols\n");
-			free(dp->symbols);
-			dp->symbols = NULL;
-			free(dp->rawsymbols);
-			dp->rawsymbols = NULL;
-
-			return false;
-		}
-
-		for(i = 0; i < dp->len; i++){
-			for(j = 0; j < dp->word_size; j++){
-				dp->bsymbols[i*dp->word_size+j] = (dp->symbols[i] >> (dp->word_size-1-j)) & 0x1;
-			}
-		}
-	}
-
-	// map down symbols if less than 2^bits_per_word unique symbols
-	if(dp->alph_size < dp->maxsymbol + 1){
-		for(i = 0; i < dp->len; i++) dp->symbols[i] = (byte)symbol_map_down_table[dp->symbols[i]];
-	} 
-
-	return true;
-}
-
-
-bool read_file(const char *file_path, data_t *dp){
-	FILE *file; 
-	int mask, j, max_symbols;
-	long rc, i;
-
-	file = fopen(file_path, "rb");
-	if(!file){
-		printf("Error: could not open '%s'\n", file_path);
-		return false;
-	}
-
-	rc = (long)fseek(file, 0, SEEK_END);
-	if(rc < 0){
-		printf("Error: fseek failed\n");
-		fclose(file);
-		return false;
-	}
-
-	dp->len = ftell(file);
-	if(dp->len < 0){
-		printf("Error: ftell failed\n");
-		fclose(file);
-		return false;
-	}
-
-	rewind(file);
-
-	if(dp->len == 0){
-		printf("Error: '%s' is empty\n", file_path);
-		fclose(file);
-		return false;
-	}
-
-	dp->symbols = (byte*)malloc(sizeof(byte)*dp->len);
-	dp->rawsymbols = (byte*)malloc(sizeof(byte)*dp->len);
-        if((dp->symbols == NULL) || (dp->rawsymbols == NULL)){
-                printf("Error: failure to initialize memory for symbols\n");
-                fclose(file);
-                if(dp->symbols != NULL) {
-                        free(dp->symbols);
-                        dp->symbols = NULL;
-                }
-                if(dp->rawsymbols != NULL) {
-                        free(dp->rawsymbols);
-                        dp->rawsymbols = NULL;
-                }
-                return false;
-        }
-
-	rc = fread(dp->symbols, sizeof(byte), dp->len, file);
-	if(rc != dp->len){
-		printf("Error: file read failure\n");
-		fclose(file);
-		free(dp->symbols);
-		dp->symbols = NULL;
-		free(dp->rawsymbols);
-		dp->rawsymbols = NULL;
-		return false;
-	}
-	fclose(file);
-
-	//Do we need to establish the word size?
-	if(dp->word_size == 0) {
-		//Yes. Establish the word size using the highest order bit in use
-		byte datamask = 0;
-		byte curbit = 0x80;
-
-		for(i = 0; i < dp->len; i++) {
-			datamask = datamask | dp->symbols[i];
-		}
-
-		for(i=8; (i>0) && ((datamask & curbit) == 0); i--) {
-			curbit = curbit >> 1;
-		}
-
-		dp->word_size = i;
-       } else {
-                byte datamask = 0;
-		byte curbit = 0x80;
-
-                for(i = 0; i < dp->len; i++) {
-                        datamask = datamask | dp->symbols[i];
-                }
-
-                for(i=8; (i>0) && ((datamask & curbit) == 0); i--) {
-                        curbit = curbit >> 1;
-                }
-
-                if( i < dp->word_size ) {
-                        printf("Warning: Symbols appear to be narrower than described.\n");
-                } else if( i > dp->word_size ) {
-                        printf("Incorrect bit width specification: Data does not fit within described bit width.\n");
-                        free(dp->symbols);
-                        dp->symbols = NULL;
-                        free(dp->rawsymbols);
-                        dp->rawsymbols = NULL;
-                        return false;
-                }
-        }
-
-
-	memcpy(dp->rawsymbols, dp->symbols, sizeof(byte)* dp->len);
-	dp->maxsymbol = 0;
-
-	max_symbols = 1 << dp->word_size;
-	int symbol_map_down_table[max_symbols];
-
-	// create symbols (samples) and check if they need to be mapped down
-	dp->alph_size = 0;
-	memset(symbol_map_down_table, 0, max_symbols*sizeof(int));
-	mask = max_symbols-1;
-	for(i = 0; i < dp->len; i++){ 
-		dp->symbols[i] &= mask;
-		if(dp->symbols[i] > dp->maxsymbol) dp->maxsymbol = dp->symbols[i];
-		if(symbol_map_down_table[dp->symbols[i]] == 0) symbol_map_down_table[dp->symbols[i]] = 1;
-	}
-
-	for(i = 0; i < max_symbols; i++){
-		if(symbol_map_down_table[i] != 0) symbol_map_down_table[i] = (byte)dp->alph_size++;
-	}
-
-	// create bsymbols (bitstring) using the non-mapped data
-	dp->blen = dp->len * dp->word_size;
-	if(dp->word_size == 1) dp->bsymbols = dp->symbols;
-	else{
-		dp->bsymbols = (byte*)malloc(dp->blen);
-		if(dp->bsymbols == NULL){
-			printf("Error: failure to initialize memory for bsymbols\n");
-			free(dp->symbols);
-			dp->symbols = NULL;
-			free(dp->rawsymbols);
-			dp->rawsymbols = NULL;
-			return false;
-		}
-
-		for(i = 0; i < dp->len; i++){
-			for(j = 0; j < dp->word_size; j++){
-				dp->bsymbols[i*dp->word_size+j] = (dp->symbols[i] >> (dp->word_size-1-j)) & 0x1;
-			}
-		}
-	}
-
-	// map down symbols if less than 2^bits_per_word unique symbols
-	if(dp->alph_size < dp->maxsymbol + 1){
-		for(i = 0; i < dp->len; i++) dp->symbols[i] = (byte)symbol_map_down_table[dp->symbols[i]];
-	} 
-
-	return true;
-}
+void unmap_file(const byte *buffer, long len);
 
 /* This is xoshiro256** 1.0*/
 /*This implementation is derived from David Blackman and Sebastiano Vigna, which they placed into
@@ -496,53 +125,13 @@ static inline uint64_t xoshiro256starstar(uint64_t *xoshiro256starstarState)
 /* This is the jump function for the generator. It is equivalent
    to 2^128 calls to xoshiro256starstar(); it can be used to generate 2^128
    non-overlapping subsequences for parallel computations. */
-void xoshiro_jump(unsigned int jump_count, uint64_t *xoshiro256starstarState) {
-	static const uint64_t JUMP[] = { 0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c };
-	uint64_t s0 = 0;
-	uint64_t s1 = 0;
-	uint64_t s2 = 0;
-	uint64_t s3 = 0;
-
-	for(unsigned int j=0; j < jump_count; j++) {
-		for(unsigned int i = 0; i < sizeof JUMP / sizeof *JUMP; i++)
-			for(unsigned int b = 0; b < 64; b++) {
-				if (JUMP[i] & ((uint64_t)1) << b) {
-					s0 ^= xoshiro256starstarState[0];
-					s1 ^= xoshiro256starstarState[1];
-					s2 ^= xoshiro256starstarState[2];
-					s3 ^= xoshiro256starstarState[3];
-				}
-				xoshiro256starstar(xoshiro256starstarState);	
-			}
-			
-		xoshiro256starstarState[0] = s0;
-		xoshiro256starstarState[1] = s1;
-		xoshiro256starstarState[2] = s2;
-		xoshiro256starstarState[3] = s3;
-	}
-}
+void xoshiro_jump(unsigned int jump_count, uint64_t *xoshiro256starstarState);
 
 //This seeds using an external source
 //We use /dev/urandom here. 
 //We could alternately use the RdRand (or some other OS or HW source of pseudo-random numbers)
-void seed(uint64_t *xoshiro256starstarState){
-	FILE *infp;
-
-	if((infp=fopen("/dev/urandom", "rb"))==NULL) {
-		perror("Can't open random source. Reverting to a deterministic seed.");
-		exit(-1);
-	} 
-
-	if(fread(xoshiro256starstarState, sizeof(uint64_t), 4, infp)!=4) {
-		perror("Can't read random seed");
-		exit(-1);
-	}
-
-	if(fclose(infp)!=0) {
-		perror("Couldn't close random source");
-		exit(-1);
-	}
-}
+//Returns false if the source couldn't be read.
+bool seed(uint64_t *xoshiro256starstarState);
 
 /*Return an integer in the range [0, high], without modular bias*/
 /*This is a slight modification of Lemire's approach (as we want [0,s] rather than [0,s)*/
@@ -559,32 +148,7 @@ void seed(uint64_t *xoshiro256starstarState){
   * This approach allows us to avoid _any_ modular reductions with high probability, and at worst case one
   * reduction. It's an opaque approach, but lovely.
   */
-uint64_t randomRange64(uint64_t s, uint64_t *xoshiro256starstarState){
-	uint64_t x;
-	__uint128_t m;
-	uint64_t l;
-
-	x = xoshiro256starstar(xoshiro256starstarState);
-
-	if(UINT64_MAX == s) {
-		return x;
-	} else {
-		s++; // We want an integer in the range [0,s], not [0,s)
-		m = (__uint128_t)x * (__uint128_t)s;
-		l = (uint64_t)m; //This is m mod 2^64
-
-		if(l<s) {
-			uint64_t t = ((uint64_t)(-s)) % s; //t = (2^64 - s) mod s (by definition of unsigned arithmetic in C)
-			while(l < t) {
-				x = xoshiro256starstar(xoshiro256starstarState);
-				m = (__uint128_t)x * (__uint128_t)s;
-				l = (uint64_t)m; //This is m mod 2^64
-			}
-		}
-
-		return (uint64_t)(m >> 64U); //return floor(m/2^64)
-	}
-}
+uint64_t randomRange64(uint64_t s, uint64_t *xoshiro256starstarState);
 
 /*
  * This function produces a double that is uniformly distributed in the interval [0, 1).
@@ -595,33 +159,81 @@ uint64_t randomRange64(uint64_t s, uint64_t *xoshiro256starstarState){
  * resulting double, not the significand. We get a double uniformly distributed in the range [0, 1).  
  * The delta between adjacent values is 2^(-53).
  */
-double randomUnit(uint64_t *xoshiro256starstarState) {
-	return((xoshiro256starstar(xoshiro256starstarState) >> 11) * 1.1102230246251565e-16);
+double randomUnit(uint64_t *xoshiro256starstarState);
+
+//The number of interleaved xoshiro256** generators in a random_stream, and the number of variates that
+//are generated at a time (a multiple of XOSHIRO_LANES)
+#define XOSHIRO_LANES 4
+#define RANDOM_BUFFER_LEN 512
+
+//A source of variates for the hot loops (the shuffles and the restart simulations). It runs XOSHIRO_LANES
+//independent xoshiro256** generators side by side, each a jump (2^128 outputs) from the last, so
+//that they can be stepped together in SIMD lanes, and hands out their outputs from a buffer.
+//The buffer holds the lanes' outputs interleaved: buffer[XOSHIRO_LANES*i + k] is output i of lane k.
+struct random_stream {
+	uint64_t state[4][XOSHIRO_LANES];	// state[j][k] is word j of lane k's xoshiro256** state
+	uint64_t buffer[RANDOM_BUFFER_LEN];
+	unsigned int next;			// the next unused variate in buffer
+};
+
+//Sets up the stream so that lane k starts at xoshiro256starstarState jumped first_jump + k times.
+//Streams set up with first_jump values XOSHIRO_LANES apart don't overlap.
+void random_stream_init(struct random_stream *rs, const uint64_t *xoshiro256starstarState, unsigned int first_jump);
+
+//splitmix64, the generator recommended for filling a xoshiro256** state from a 64-bit value
+static inline uint64_t splitmix64(uint64_t *x) {
+	uint64_t z = (*x += 0x9e3779b97f4a7c15);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+	return z ^ (z >> 31);
 }
 
-// Fisher-Yates Fast (in place) shuffle algorithm
-void FYshuffle(byte data[], byte rawdata[], const int sample_size, uint64_t *xoshiro256starstarState) {
-	long int r;
-	static mutex shuffle_mutex;
-	unique_lock<mutex> lock(shuffle_mutex);
+//Sets up the stream for item index of a computation keyed by key, so that the item's variates depend only
+//on the key and the index, rather than on which thread draws them or in what order. The lanes' states come
+//from splitmix64, started at a mix of the two: unlike jumping, this doesn't take time proportional to
+//the index, and the chance that two of the streams overlap is negligible.
+void random_stream_init_keyed(struct random_stream *rs, uint64_t key, uint64_t index);
 
-	for (long int i = sample_size - 1; i > 0; --i) {
-		r = (long int)randomRange64((uint64_t)i, xoshiro256starstarState);
-		SWAP(data[r], data[i]);
-		SWAP(rawdata[r], rawdata[i]);
-	}
+//Refills the buffer of the stream with the next RANDOM_BUFFER_LEN variates
+void random_stream_refill(struct random_stream *rs);
+
+static inline uint64_t random_stream_next(struct random_stream *rs) {
+	if(rs->next == RANDOM_BUFFER_LEN) random_stream_refill(rs);
+	return rs->buffer[rs->next++];
 }
 
-// Quick sum array  // TODO
-long int sum(const byte arr[], const int sample_size) {
-	long int sum = 0;
-	for (long int i = 0; i < sample_size; ++i) {
-		sum += arr[i];
+//randomRange64, drawing from a random_stream. This is the same multiply-shift method with rejection, so the
+//result is uniform on [0, s]; the rejection branch is almost never taken.
+static inline uint64_t randomRange64(uint64_t s, struct random_stream *rs) {
+	__uint128_t m;
+	uint64_t l;
+
+	if(UINT64_MAX == s) return random_stream_next(rs);
+
+	s++; // We want an integer in the range [0,s], not [0,s)
+	m = (__uint128_t)random_stream_next(rs) * (__uint128_t)s;
+	l = (uint64_t)m; //This is m mod 2^64
+
+	if(l < s) {
+		uint64_t t = ((uint64_t)(-s)) % s; //t = (2^64 - s) mod s
+		while(l < t) {
+			m = (__uint128_t)random_stream_next(rs) * (__uint128_t)s;
+			l = (uint64_t)m;
+		}
 	}
 
-	return sum;
+	return (uint64_t)(m >> 64U); //return floor(m/2^64)
+}
+
+//randomUnit, drawing from a random_stream
+static inline double randomUnit(struct random_stream *rs) {
+	return((random_stream_next(rs) >> 11) * 1.1102230246251565e-16);
 }
 
+// Quick sum array  // TODO
+long int sum(const byte arr[], const int sample_size);
+
 // Quick sum std::array // TODO
 template<size_t LENGTH>
 int sum(const array<int, LENGTH> &arr) {
@@ -646,111 +258,34 @@ T sum(const vector<T> &v) {
 
 // Calculate baseline statistics
 // Finds mean, median, and whether or not the data is binary
-void calc_stats(const data_t *dp, double &rawmean, double &median) {
-
-	// Calculate mean
-	rawmean = sum(dp->rawsymbols, dp->len) / (double)dp->len;
-
-	// Sort in a vector for median/min/max
-	vector<byte> v(dp->symbols, dp->symbols + dp->len);
-	sort(v.begin(), v.end());
-
-	long int half = dp->len / 2;
-	if(dp->alph_size == 2) {
-		//This isn't necessarily true, but we are supposed to set it this way.
-		//See 5.1.5, 5.1.6.
-		median = 0.5;
-	} else {
-		if((dp->len & 1) == 1) {
-			//the length is odd
-			median = v[half];
-		} else {
-			//the length is even
-			median = (v[half] + v[half - 1]) / 2.0;
-		}
-	}
-}
+void calc_stats(const data_t *dp, double &rawmean, double &median);
 
 
 // Map initialization for integers
-void map_init(map<byte, int> &m) {
-	for (int i = 0; i < 256; i++) {
-		m[i] = 0;
-	}
-}
+void map_init(map<byte, int> &m);
 
 // Map initialization for doubles
-void map_init(map<byte, double> &m) {
-	for (int i = 0; i < 256; i++) {
-		m[i] = 0.0;
-	}
-}
+void map_init(map<byte, double> &m);
 
 // Map initialization for pair<byte, byte> to int
-void map_init(map<pair<byte, byte>, int> &m) {
-	for (int i = 0; i < 256; i++) {
-		for (int j = 0; j < 256; j++) {
-			m[pair<byte, byte>(i, j)] = 0;
-		}
-	}
-}
+void map_init(map<pair<byte, byte>, int> &m);
 
 // Calculates proportions of each value as an index
-void calc_proportions(const byte data[], vector<double> &p, const int sample_size) {
-	for (int i = 0; i < sample_size; i++) {
-		p[data[i]] += (1.0 / sample_size);
-	}
-}
+void calc_proportions(const byte data[], vector<double> &p, const int sample_size);
 
 // Calculates proportions of each value as an index
-void calc_counts(const byte data[], vector<int> &c, const int sample_size) {
-	for (int i = 0; i < sample_size; i++) {
-		c[data[i]] ++;
-	}
-}
+void calc_counts(const byte data[], vector<int> &c, const int sample_size);
 
 // Determines the standard deviation of a dataset
-double std_dev(const vector<int> x, const double x_mean) {
-	double sum = 0.0;
-
-	for (unsigned int i = 0; i < x.size(); i++) {
-		sum += pow(x[i] - x_mean, 2);
-	}
-
-	return sqrt(sum / x.size());
-}
+double std_dev(const vector<int> x, const double x_mean);
 
 // Quick formula for n choose 2 (which can be simplified to [n^2 - n] / 2)
-long int n_choose_2(const long int n) {
-	return ((n*n) - n) / 2;
-}
+long int n_choose_2(const long int n);
 
-vector<byte> substr(const byte text[], const int pos, const int len, const int sample_size) {
-	int substr_len = len;
-
-	if (pos + len > sample_size) {
-		substr_len = sample_size - pos;
-	}
-
-	vector<byte> substring;
-
-	for (int i = 0; i < substr_len; i++) {
-		substring.push_back(text[pos + i]);
-	}
-
-	return substring;
-}
+vector<byte> substr(const byte text[], const int pos, const int len, const int sample_size);
 
 // Fast substring with no bounds checking
-array<byte, 16> fast_substr(const byte text[], const int pos, const int len) {
-	array<byte, 16> substring = { 0 };
-
-	for (int i = 0; i < len; i++) {
-		substring[i] = text[pos + i];
-	}
-
-	return substring;
-}
+array<byte, 16> fast_substr(const byte text[], const int pos, const int len);
 
 template<typename T>
 T max_vector(const vector<T> &vals) {
@@ -776,162 +311,37 @@ T max_arr(const T* vals, const unsigned int k){
 	return max;
 }
 
-double divide(const int a, const int b) {
-	return ((double)a / (double)b);
-}
-
-double prediction_estimate_function(long double p, long r, long N){
-	long double q, x, xlast=0.0L;
-	assert(p > 0.0L); //In fact, it is >= 1/k
-	assert(p < 1.0L);
-
-	q = 1.0L-p;
-	x = 1.0L;
-
-	//We know that 
-	// * x is in the interval [1,1/p] which is a subset of [1,k]
-	// * the sequence is monotonic up (so x >= xlast).
-	//As such we don't need much fancyness for looking for "equality"
-	for(int i = 0; (i <= 65) && ((x - xlast) > (LDBL_EPSILON*x)); i++) {
-		xlast = x;
-		x = 1.0L + q*powl(p, r)*powl(x, r+1.0L);
-		//We expect this convergence to be monotonic up.
-		assert(x >= xlast);
-		//We expect x<=1/p
-		assert(p*x <= 1.0L);
-	}
-
-	return((double)(logl(1.0L-p*x) - logl((r+1.0L-r*x)*q) - (N+1.0L)*logl(x)));
-}
-
-double calc_p_local(long max_run_len, long N, double ldomain){
-	int j;
-	double p, log_alpha;
-	double lastP, pVal;
-	double lvalue, hvalue;
-	double hbound, lbound;
-	double hdomain;
-
-	// binary search for p_local
-	log_alpha = log(0.99);
-	
-	hdomain = 1.0;
-
-	lbound = ldomain;
-	hbound = hdomain;
-
-	lvalue = DBL_INFINITY;
-	hvalue = -DBL_INFINITY;
-
-	//Note that the bounds are in [0,1], so overflows aren't an issue
-	//But underflows are.
-	p = (lbound + hbound) / 2.0;
-	pVal = prediction_estimate_function(p, max_run_len+1, N);
-
-	//We don't need the initial pVal invariant, as our initial bounds are infinite.
-	//We don't need the initial bounds, as they are set to the domain bounds
-	for(j=0; j<ITERMAX; j++) {
-		//Have we reached "equality"?
-		if(relEpsilonEqual(pVal, log_alpha, ABSEPSILON, RELEPSILON, 4)) break;
-
-		//Now update based on the found pVal
-		if(log_alpha < pVal) {
-			lbound = p;
-			lvalue = pVal;
-		} else {
-			hbound = p;
-			hvalue = pVal;
-		}
-
-		//We now verify that ldomain <= lbound < p < hbound <= hdomain
-		//and that target in [ lvalue, hvalue ]
-		if(lbound >= hbound) {
-			p = fmin(fmax(lbound, hbound),hdomain);
-			break;
-		}
-
-		//invariant. If this isn't true, then we can't evaluate here.
-		if(!(INCLOSEDINTERVAL(lbound, ldomain, hdomain) && INCLOSEDINTERVAL(hbound,  ldomain, hdomain))) {
-			p = hdomain;
-			break;
-		}
+double divide(const int a, const int b);
 
-		//invariant. If this isn't true, then seeking the value within this interval doesn't make sense.
-		if(!INCLOSEDINTERVAL(log_alpha, lvalue, hvalue)) {
-			p = hdomain;
-			break;
-		}
-
-		//Update p
-		lastP = p;
-		p = (lbound + hbound) / 2.0;
+double prediction_estimate_function(long double p, long r, long N);
 
-		//invariant. If this isn't true, then further calculation isn't really meaningful.
-		if(!INOPENINTERVAL(p,  lbound, hbound)) {
-			p = hbound;
-			break;
-		}
+//calc_p_local stops interpolating once the function is within this relative distance of its target.
+#define P_LOCAL_NEAR_ROOT 1e-9
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wfloat-equal"
-		//Look for a cycle
-		if(lastP == p) {
-			p = hbound;
-			break;
-		}
-#pragma GCC diagnostic pop
+//The most results that calc_p_local keeps for reuse
+#define P_LOCAL_CACHE_MAX 4096
 
-		pVal = prediction_estimate_function(p, max_run_len+1, N);
+//This is a bracketing search for the value of p where prediction_estimate_function(p, r, N) = log(0.99).
+//Once there are function values at both ends of the bracket, the next point is found using regula falsi.
+//Regula falsi tends to approach the root from one side, leaving the other end of the bracket where it was;
+//when the same end of the bracket has moved twice in a row, we instead deliberately overshoot the interpolated
+//root by the distance that end last moved, which (for this smooth function) lands just past the root and
+//collapses the bracket from the other side. Any step that doesn't land within the bracket (or that
+//would move the same end of the bracket a fourth time in a row) is replaced by a bisection step, and once
+//the function value is within P_LOCAL_NEAR_ROOT of the target only bisection is used, so the final result
+//is settled the same way as in a pure bisection search.
+//The invariants and the failure handling are the same as for bisection.
+//Results are kept for reuse, keyed on all three arguments, so a result never depends on earlier calls.
+double calc_p_local(long max_run_len, long N, double ldomain);
 
-		//invariant: If this isn't true, then this isn't loosely monotonic
-		if(!INCLOSEDINTERVAL(pVal, lvalue, hvalue)) {
-			p = hbound;
-			break;
-		}
-	}//for loop
+double predictionEstimate(long C, long N, long max_run_len, long k, const char *testname, const int verbose, const char *label);
 
-	return p;
-}
+//Where the estimators write their verbose output, or NULL for standard output. Each thread has its own, so
+//that estimators run as concurrent tasks can each write to a buffer of their own, to be printed in order.
+extern thread_local FILE *verbose_stream;
 
-double predictionEstimate(long C, long N, long max_run_len, long k, const char *testname, const int verbose, const char *label) {
-	double curMax;
-	double p_local=-1.0;
-	double entEst;
-	double p_global;
-	double p_globalPrime;
-
-	curMax = 1.0 / ((double)k);
-
-	p_global = (double)C/(double)N;
-
-	if(p_global > 0) p_globalPrime = min(1.0, p_global + ZALPHA*sqrt((p_global*(1.0-p_global))/((double)N-1.0)));
-	else p_globalPrime = 1.0 - pow(0.01, 1.0/(double)N);
-
-	curMax = fmax(curMax, p_globalPrime);
-	if((curMax < 1.0) && (prediction_estimate_function(curMax, max_run_len+1, N) > log(0.99))) {
-		p_local = calc_p_local(max_run_len, N, curMax);
-		curMax = fmax(curMax, p_local);
-	}
-
-	entEst = -log2(curMax);
-
-	if(verbose == 1) {
-		if(p_local > 0.0) printf("%s %s Prediction Estimate: N = %ld, Pglobal' = %.17g (C = %ld) Plocal = %.17g (r = %ld)\n", label, testname, N, p_globalPrime, C, p_local, max_run_len+1);
-		else printf("%s %s Prediction Estimate: N = %ld, Pglobal' = %.17g (C = %ld) Plocal can't affect result (r = %ld)\n", label, testname, N, p_globalPrime, C, max_run_len+1);
-	} else if(verbose == 2) {
-		printf("%s %s Prediction Estimate: C = %ld\n", label, testname, C);
-		printf("%s %s Prediction Estimate: r = %ld\n", label, testname, max_run_len + 1);
-		printf("%s %s Prediction Estimate: N = %ld\n", label, testname, N);
-		printf("%s %s Prediction Estimate: P_global = %.17g\n", label, testname, p_global);
-		printf("%s %s Prediction Estimate: P_global' = %.17g\n", label, testname, p_globalPrime);
-
-		if(p_local > 0.0) printf("%s %s Prediction Estimate: P_local = %.17g\n", label, testname, p_local);
-		else printf("%s %s Prediction Estimate: P_local can't change the result.\n", label, testname);
-
-		printf("%s %s Prediction Estimate: min entropy = %.17g\n", label, testname, entEst);
-	}
-	return entEst;
-}
+//printf to the calling thread's verbose_stream
+int verbose_printf(const char *format, ...) __attribute__((format(printf, 1, 2)));
 
 //The idea here is that we've given an array of pointers (binaryDict). 
 //We are trying to produce the address of the length-2 array associated with the length-d prefix "b".
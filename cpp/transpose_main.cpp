@@ -1,4 +1,5 @@
 #include "shared/utils.h"
+#include "shared/transpose.h"
 
 #include <stdio.h>
 #include <cstdlib>
@@ -13,9 +14,10 @@
 
 
 [[ noreturn ]] void print_usage(){
-	printf("Usage is: ea_transpose [-v] [-l <index>] <file> <outfile>\n");
+	printf("Usage is: ea_transpose [-v] [-l <index> | -b] <file> <outfile>\n");
 	printf("\t [-v]: Increase verbosity.\n");
 	printf("\t [-l <index>]\t Read the <index> substring of 1000000 samples.\n");
+	printf("\t [-b]\t Batch mode. Transpose every complete block of 1000000 samples, writing the blocks in order.\n");
 	printf("\t <file>: File with (blocks of) 1000 sets of restart data, each set being 1000 samples.\n");
 	printf("\t The result is saved in <file>.column\n");
 	printf("\t This program computes the transpose of the restart matrix, and produces column data appropriate testing with the other tools.\n"); 
@@ -24,6 +26,59 @@
 	exit(-1);
 }
 
+//Transposes each complete restart matrix in the input file into the output file
+int transpose_batch(const char *in_path, const char *out_path, int verbose) {
+	const int r=1000;
+	const int c=1000;
+	const byte *buffer;
+	byte *transposed;
+	long file_len, matrix_count;
+	FILE *fp;
+
+	if(verbose>0) printf("Opening input file: '%s'\n", in_path);
+
+	if(!map_file(in_path, &buffer, &file_len)){
+		printf("Error reading file.\n");
+		print_usage();
+	}
+
+	matrix_count = file_len / (r*c);
+	if(matrix_count == 0) {
+		printf("Data must be at least %d samples.\n", r*c);
+		print_usage();
+	}
+
+	if((file_len % (r*c)) != 0) printf("Warning: Ignoring the last %ld samples, which don't make up a complete restart matrix.\n", file_len % (r*c));
+	if(verbose > 0) printf("Transposing %ld restart matrices\n", matrix_count);
+
+	transposed = (byte*)malloc(matrix_count*r*c);
+	if(transposed == NULL){
+		printf("Error: failure to initialize memory for columns\n");
+		exit(-1);
+	}
+
+	#pragma omp parallel for
+	for(long m = 0; m < matrix_count; m++) {
+		transpose_matrix(buffer + m*r*c, transposed + m*r*c, r, c);
+	}
+
+	if(verbose>0) printf("Opening output file: '%s'\n", out_path);
+	if((fp = fopen(out_path, "wb"))==NULL) {
+		perror("Can't open output file");
+                print_usage();
+	}
+
+	if(fwrite(transposed, sizeof(byte), matrix_count*r*c, fp) != (size_t)(matrix_count*r*c)) {
+		perror("Can't write output");
+		exit(-1);
+	}
+
+	fclose(fp);
+	free(transposed);
+	unmap_file(buffer, file_len);
+	return 0;
+}
+
 int main(int argc, char* argv[])
 {
 	int verbose = 0;
@@ -33,13 +88,18 @@ int main(int argc, char* argv[])
 	unsigned long long inint;
 	unsigned long subsetIndex=ULONG_MAX;
 	unsigned long subsetSize=0;
+	bool batch=false;
 	data_t data;
+	byte *transposed;
 	FILE *fp;
 
 	data.word_size = 0;
 
-        while ((opt = getopt(argc, argv, "vl:")) != -1) {
+        while ((opt = getopt(argc, argv, "vl:b")) != -1) {
                 switch(opt) {
+                        case 'b':
+                                batch = true;
+                                break;
                         case 'v':
                                 verbose++;
                                 break;
@@ -65,6 +125,14 @@ int main(int argc, char* argv[])
 		print_usage();
 	}
 
+	if(batch) {
+		if(subsetSize != 0) {
+			printf("The -l and -b options can't be used together.\n");
+			print_usage();
+		}
+		return transpose_batch(argv[0], argv[1], verbose);
+	}
+
 	if(verbose>0) printf("Opening input file: '%s'\n", argv[0]);
 
         if(!read_file_subset(argv[0], &data, subsetIndex, subsetSize)){
@@ -85,15 +153,20 @@ int main(int argc, char* argv[])
                 print_usage();
 	}
 
-	for(int i=0; i<c; i++) {
-		for(int j=0; j<r; j++) {
-			if(fwrite(data.rawsymbols+c*j + i, sizeof(byte), 1, fp) != 1) {
-				perror("Can't write output");
-				exit(-1);
-			}
-		}
+	transposed = (byte*)malloc(r*c);
+	if(transposed == NULL){
+		printf("Error: failure to initialize memory for columns\n");
+		exit(-1);
+	}
+
+	transpose_matrix(data.rawsymbols, transposed, r, c);
+
+	if(fwrite(transposed, sizeof(byte), r*c, fp) != (size_t)(r*c)) {
+		perror("Can't write output");
+		exit(-1);
 	}
 
+	free(transposed);
 	fclose(fp);
 	free_data(&data);
 	return 0;